@@ -0,0 +1,302 @@
+// Measures the speed of the turmite engine on fixed workloads, so that it can be tracked across
+// versions.
+//
+// Two kinds of workload are run for each grid and movement, on a single thread:
+//  - range: every machine in a fixed range of the odometer (without the searchers' symmetry
+//    restrictions or filters), which is dominated by machines that stop after a few steps
+//  - machine: one known long-running machine, run again and again
+//
+// Each workload is run by the scalar engine (turmite_engine.h), with the translation detector and
+// without it (mode "no_translation", as with --no-translation), and by the batch engine
+// (batch_engine.h, as with --batch: mode "batch_" and the kernel it was compiled with, avx512,
+// avx2 or portable), with the turmites still running after its limit run again by the scalar
+// engine. Langton's ant is also run on a tiled grid (mode "tiled", as with --unbounded, where R is
+// not used), and the 5-state busy beaver (47 million steps) with macro-steps as well (mode "macro",
+// macro_engine.h). For each we print a line of CSV: the number of candidates and steps simulated,
+// the time spent resetting the grid and the time spent simulating, and the rates derived from
+// them. The scalar modes time each candidate separately, which adds a few tens of nanoseconds per
+// candidate to the range workloads. The batch engine resets its lanes inside its loop, so
+// reset_seconds is left empty for it.
+
+// STL:
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// local:
+#include "batch_engine.h"
+#include "grid_topology.h"
+#include "journal_grid.h"
+#include "macro_engine.h"
+#include "parallel_search.h"
+#include "transition_table.h"
+#include "turmite.h"
+#include "turmite_engine.h"
+#include "turmite_search.h"
+
+typedef chrono::steady_clock Clock;
+
+struct Workload
+{
+    string name; // e.g. "range" or the machine's name
+    int R,ITS;
+    unsigned long long first,count; // range: the machines [first,first+count), machine: repeat it count times
+    vector<unsigned char> machine; // the color, move and state of each transition (empty for a range)
+};
+
+struct BenchmarkResult
+{
+    unsigned long long candidates,steps;
+    double reset_seconds,simulate_seconds;
+    bool reset_timed;
+};
+
+// the machines of a workload, one after another
+class Candidates
+{
+    public:
+
+        Candidates(const Workload &workload,int n_states,int n_colors,int n_moves)
+            : workload(workload),possible_entries(make_possible_entries(n_states,n_colors,n_moves)),
+            transitions(possible_entries,n_colors),turmite(possible_entries.size()),n_given(0)
+        {
+            if(workload.machine.empty())
+                index_to_turmite(workload.first,possible_entries,&turmite[0]);
+            else
+                for(size_t iEntry=0;iEntry<turmite.size();iEntry++)
+                    turmite[iEntry] = find(possible_entries[iEntry].begin(),possible_entries[iEntry].end(),
+                        workload.machine[iEntry]) - possible_entries[iEntry].begin();
+            transitions.compile(&turmite[0]);
+        }
+
+        const vector<vector<unsigned char> > &entries() const { return possible_entries; }
+
+        // the machine that next() last returned, as indices into entries()
+        const vector<unsigned char> &machine() const { return turmite; }
+
+        // the transitions of the next machine, or NULL if there are no more
+        const TransitionTable *next()
+        {
+            if(n_given==workload.count)
+                return NULL;
+            if(n_given>0 && workload.machine.empty())
+            {
+                // next machine of the odometer
+                size_t iEntry;
+                for(iEntry=0;iEntry<turmite.size();iEntry++)
+                {
+                    if(turmite[iEntry] < possible_entries[iEntry].size()-1)
+                    {
+                        turmite[iEntry]++;
+                        break;
+                    }
+                    turmite[iEntry] = 0;
+                }
+                if(iEntry==turmite.size())
+                    return NULL; // the range ran off the end of the odometer
+                transitions.update_after_increment(iEntry,&turmite[0]);
+            }
+            n_given++;
+            return &transitions;
+        }
+
+    private:
+
+        const Workload &workload;
+        const vector<vector<unsigned char> > possible_entries;
+        TransitionTable transitions;
+        vector<unsigned char> turmite; // turmite[i] is an index into possible_entries[i]
+        unsigned long long n_given;
+};
+
+inline double seconds_between(Clock::time_point a,Clock::time_point b)
+{
+    return chrono::duration<double>(b-a).count();
+}
+
+template<class Topology,class Movement,int N_STATES,int N_COLORS,bool TILED>
+BenchmarkResult run_scalar(const Workload &workload,bool translation=true)
+{
+    typedef TurmiteEngine<Topology,Movement,N_STATES,N_COLORS,TILED> Engine;
+    const Engine engine(workload.R,workload.ITS,N_STATES,N_COLORS,0,translation);
+    Candidates candidates(workload,N_STATES,N_COLORS,Engine::N_MOVES);
+    typename Engine::Grid grid;
+    engine.prepare_grid(grid);
+    TurmiteState t;
+    BenchmarkResult result = {0,0,0.0,0.0,true};
+    const TransitionTable *transitions;
+    while((transitions = candidates.next()))
+    {
+        const Clock::time_point t0 = Clock::now();
+        grid.clear(); // undo the writes of the previous run
+        const Clock::time_point t1 = Clock::now();
+        engine.start(t);
+        engine.run(*transitions,grid,t);
+        const Clock::time_point t2 = Clock::now();
+        result.reset_seconds += seconds_between(t0,t1);
+        result.simulate_seconds += seconds_between(t1,t2);
+        result.candidates++;
+        result.steps += t.its;
+    }
+    return result;
+}
+
+template<class Topology,class Movement,int N_STATES,int N_COLORS>
+BenchmarkResult run_batch(const Workload &workload)
+{
+    typedef BatchEngine<Topology,Movement,N_STATES,N_COLORS> Batch;
+    typedef TurmiteEngine<Topology,Movement,N_STATES,N_COLORS,false> Engine;
+    Batch batch(workload.R,workload.ITS,N_STATES,N_COLORS);
+    const Engine engine(workload.R,workload.ITS,N_STATES,N_COLORS);
+    Candidates candidates(workload,N_STATES,N_COLORS,Engine::N_MOVES);
+    typename Engine::Grid grid; // for the turmites that the batch engine gives back
+    engine.prepare_grid(grid);
+    TurmiteState t;
+    TransitionTable transitions(candidates.entries(),N_COLORS);
+    vector<vector<unsigned char> > lane_machine(Batch::LANES);
+    BenchmarkResult result = {0,0,0.0,0.0,false};
+    const Clock::time_point t0 = Clock::now();
+    batch.run([&](int iLane)
+        {
+            const TransitionTable *next = candidates.next();
+            if(next)
+                lane_machine[iLane] = candidates.machine();
+            return next;
+        },
+        [&](int iLane,RunOutcome outcome,int its,int,int)
+        {
+            if(outcome==TIMED_OUT && its<workload.ITS)
+            {
+                transitions.compile(&lane_machine[iLane][0]);
+                grid.clear();
+                engine.start(t);
+                engine.run(transitions,grid,t);
+                its = t.its;
+            }
+            result.candidates++;
+            result.steps += its;
+        });
+    result.simulate_seconds = seconds_between(t0,Clock::now());
+    return result;
+}
+
+template<class Topology,class Movement,int N_STATES,int N_COLORS>
+BenchmarkResult run_macro(const Workload &workload)
+{
+    typedef MacroEngine<Topology,Movement,N_STATES,N_COLORS> Engine;
+    const Engine engine(workload.R,workload.ITS,N_STATES,N_COLORS);
+    Candidates candidates(workload,N_STATES,N_COLORS,1+Topology::N_DIRS);
+    MacroGrid grid;
+    engine.prepare_grid(grid);
+    TurmiteState t;
+    BenchmarkResult result = {0,0,0.0,0.0,true};
+    const TransitionTable *transitions;
+    while((transitions = candidates.next()))
+    {
+        const Clock::time_point t0 = Clock::now();
+        grid.clear();
+        const Clock::time_point t1 = Clock::now();
+        engine.start(t);
+        engine.run(*transitions,grid,t);
+        const Clock::time_point t2 = Clock::now();
+        result.reset_seconds += seconds_between(t0,t1);
+        result.simulate_seconds += seconds_between(t1,t2);
+        result.candidates++;
+        result.steps += t.its;
+    }
+    return result;
+}
+
+template<class Topology,class Movement,int N_STATES,int N_COLORS>
+void report(const string &grid_name,const char *mode,const Workload &workload,const BenchmarkResult &result)
+{
+    const double seconds = result.reset_seconds + result.simulate_seconds;
+    cout << grid_name << "," << Topology::N_DIM << "," << (Movement::RELATIVE ? "relative" : "absolute") << ","
+        << N_STATES << "," << N_COLORS << "," << workload.name << "," << mode << "," << workload.R << "," << workload.ITS << ","
+        << result.candidates << "," << result.steps << "," << seconds << ",";
+    if(result.reset_timed)
+        cout << result.reset_seconds;
+    cout << "," << result.simulate_seconds << ","
+        << result.steps/seconds << "," << result.candidates/seconds << "," << 1e9*seconds/result.steps << endl;
+}
+
+template<class Topology,class Movement,int N_STATES,int N_COLORS>
+void benchmark(const string &grid_name,const Workload &workload)
+{
+    report<Topology,Movement,N_STATES,N_COLORS>(grid_name,"scalar",workload,run_scalar<Topology,Movement,N_STATES,N_COLORS,false>(workload));
+    report<Topology,Movement,N_STATES,N_COLORS>(grid_name,"no_translation",workload,
+        run_scalar<Topology,Movement,N_STATES,N_COLORS,false>(workload,false));
+    report<Topology,Movement,N_STATES,N_COLORS>(grid_name,("batch_"+string(BatchLanes::name())).c_str(),workload,
+        run_batch<Topology,Movement,N_STATES,N_COLORS>(workload));
+}
+
+// as benchmark(), and also on a tiled grid
+template<class Topology,class Movement,int N_STATES,int N_COLORS>
+void benchmark_with_tiles(const string &grid_name,const Workload &workload)
+{
+    benchmark<Topology,Movement,N_STATES,N_COLORS>(grid_name,workload);
+    report<Topology,Movement,N_STATES,N_COLORS>(grid_name,"tiled",workload,run_scalar<Topology,Movement,N_STATES,N_COLORS,true>(workload));
+}
+
+// the machines [first,first+count) of the odometer
+inline Workload range(int R,int ITS,unsigned long long first,unsigned long long count)
+{
+    Workload workload;
+    workload.name = "range";
+    workload.R = R;
+    workload.ITS = ITS;
+    workload.first = first;
+    workload.count = count;
+    return workload;
+}
+
+// one machine, given as in the results files (color, move, state of each transition), run count times
+inline Workload machine(const string &name,int R,int ITS,const vector<unsigned char> &transitions,unsigned long long count)
+{
+    Workload workload;
+    workload.name = name;
+    workload.R = R;
+    workload.ITS = ITS;
+    workload.first = 0;
+    workload.count = count;
+    workload.machine = transitions;
+    return workload;
+}
+
+int main()
+{
+    cout << "grid,dims,movement,states,colors,workload,mode,R,ITS,candidates,steps,seconds,reset_seconds,"
+        "simulate_seconds,steps_per_second,candidates_per_second,ns_per_step" << endl;
+
+    // odometer ranges, starting well into the odometer so that the first transitions vary
+    benchmark<SquareTopology<1>,AbsoluteMovement,3,2>("square",range(20,10000,1000000,1000000));
+    benchmark<SquareTopology<1>,RelativeMovement,3,2>("square",range(20,10000,1000000,1000000));
+    benchmark<SquareTopology<2>,AbsoluteMovement,3,2>("square",range(20,10000,100000000,1000000));
+    benchmark<SquareTopology<2>,RelativeMovement,3,2>("square",range(20,10000,100000000,200000));
+    benchmark<SquareTopology<3>,AbsoluteMovement,3,2>("square",range(20,10000,100000000,1000000));
+    benchmark<HexTopology,AbsoluteMovement,2,2>("hex",range(50,60000,100000,500000));
+    benchmark<HexTopology,RelativeMovement,2,3>("hex",range(50,60000,100000000,100000));
+    benchmark<TriTopology,RelativeMovement,2,2>("tri",range(200,100000,10000,20000));
+
+    // long-running machines
+    // Langton's ant: {{{1,2,0},{0,8,0}}}, wanders for about 10000 steps before building its highway
+    const unsigned char langtons_ant[] = {1,3,0, 0,4,0};
+    benchmark_with_tiles<SquareTopology<2>,RelativeMovement,1,2>("square",machine("langtons_ant",50,10000,
+        vector<unsigned char>(langtons_ant,langtons_ant+6),5000));
+    // a long-running hex machine: {{{1,16,1},{1,1,0},{1,8,0}},{{1,16,0},{2,8,0},{1,0,0}}}
+    const unsigned char t2893[] = {0,5,1,1,1,0,1,4,0,1,5,0,2,4,0,1,0,0};
+    benchmark<HexTopology,RelativeMovement,2,3>("hex",machine("t2893",50,60000,
+        vector<unsigned char>(t2893,t2893+18),20000));
+    // the 5-state busy beaver (Marxen and Buntrock), with its states renumbered so that the halt is
+    // in state 2: halts after 47176870 steps leaving 4098 cells set, within 12300 cells of the start
+    const unsigned char bb5[] = {1,1,1, 1,2,4, 1,1,4, 1,1,1, 1,0,0, 0,2,0, 1,2,0, 1,2,3, 1,1,3, 0,2,2};
+    const Workload busy_beaver = machine("bb5",13000,50000000,vector<unsigned char>(bb5,bb5+30),3);
+    report<SquareTopology<1>,AbsoluteMovement,5,2>("square","scalar",busy_beaver,
+        run_scalar<SquareTopology<1>,AbsoluteMovement,5,2,false>(busy_beaver));
+    report<SquareTopology<1>,AbsoluteMovement,5,2>("square","macro",busy_beaver,
+        run_macro<SquareTopology<1>,AbsoluteMovement,5,2>(busy_beaver));
+    return 0;
+}
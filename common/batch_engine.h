@@ -0,0 +1,448 @@
+// Running many turmites at once, in lockstep.
+//
+// A single turmite's step is one long chain of dependent loads: the cell gives its color, the color
+// gives the transition, the transition gives the next cell. Here LANES turmites, each with its own
+// grid and copy of its transition table, are held in structure-of-arrays form and take one step
+// each at the same time, in SIMD registers: the cells' colors, the transitions and the moves'
+// offsets are each fetched for every lane by one gather, and the cells written back (with the undo
+// log) by scatters. A mask keeps track of the lanes that are still running. When a lane halts,
+// leaves the grid, repeats a configuration or runs out of steps, its result is reported and the
+// lane is refilled with the next candidate straight away.
+//
+// The kernel is written once, against BatchLanes: 16 lanes with AVX-512, 8 with AVX2 (the scatters
+// are then done one lane at a time), and otherwise 8 lanes in plain arrays, for any processor. Which
+// is used depends on how the code is compiled (e.g. -march=native, see BUILD.txt).
+//
+// The grids are dense, with the border and step offsets of turmite_engine.h, so every candidate
+// gets the same outcome, step count and population as there. The cells are bytes, whatever the
+// number of dimensions. Only complete turmites can be run (as in the odometer search): a lane never
+// stops for an undefined transition. The configurations are hashed with 32-bit keys that the lanes
+// can compute in their registers, a match being confirmed against the lane's undo log as in
+// cycle_detection.h. A lane takes at most MAX_ITS steps, before the translation detector would
+// start to follow it (see translation_detection.h): most turmites stop well before then, and the
+// caller runs the few that don't again with TurmiteEngine.
+
+#ifndef BATCH_ENGINE_H
+#define BATCH_ENGINE_H
+
+// stdlib:
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// STL:
+#include <algorithm>
+#include <new>
+#include <vector>
+
+// local:
+#include "grid_topology.h"
+#include "transition_table.h"
+#include "translation_detection.h"
+#include "turmite.h"
+#include "turmite_engine.h"
+
+// The operations of the kernel on N lanes of 32-bit ints (Ints), and on a set of lanes (Mask).
+#if defined(__AVX512F__)
+struct BatchLanes
+{
+    static const int N = 16;
+    typedef __m512i Ints;
+    typedef __mmask16 Mask;
+
+    static const char *name() { return "avx512"; }
+
+    static Ints set(int a) { return _mm512_set1_epi32(a); }
+    static Ints load(const int *p) { return _mm512_loadu_si512((const void*)p); }
+    static void store(int *p,Ints a) { _mm512_storeu_si512((void*)p,a); }
+    static Ints add(Ints a,Ints b) { return _mm512_add_epi32(a,b); }
+    static Ints sub(Ints a,Ints b) { return _mm512_sub_epi32(a,b); }
+    static Ints mul(Ints a,Ints b) { return _mm512_mullo_epi32(a,b); }
+    static Ints max(Ints a,Ints b) { return _mm512_max_epi32(a,b); }
+    static Ints bit_and(Ints a,Ints b) { return _mm512_and_si512(a,b); }
+    static Ints bit_or(Ints a,Ints b) { return _mm512_or_si512(a,b); }
+    static Ints bit_xor(Ints a,Ints b) { return _mm512_xor_si512(a,b); }
+    template<int S> static Ints shift_right(Ints a) { return _mm512_srli_epi32(a,S); }
+
+    static Mask eq(Ints a,Ints b) { return _mm512_cmpeq_epi32_mask(a,b); }
+    static Mask both(Mask a,Mask b) { return a & b; }
+    static Mask either(Mask a,Mask b) { return a | b; }
+    static Mask except(Mask a,Mask b) { return (Mask)(a & ~b); }
+    static Mask mask(int bits) { return (Mask)bits; }
+    static int bits(Mask m) { return m; }
+    static Ints select(Mask m,Ints a,Ints b) { return _mm512_mask_blend_epi32(m,b,a); } // a where m is set, else b
+
+    // p[i] for each lane, and the 4 bytes from q+i on
+    static Ints gather(const int *p,Ints i) { return _mm512_i32gather_epi32(i,(const void*)p,4); }
+    static Ints gather_bytes(const unsigned char *q,Ints i) { return _mm512_i32gather_epi32(i,(const void*)q,1); }
+    // for the lanes in m: p[i] = a, and q[i] = the low byte of a (the other 3 bytes of a are written
+    // to q[i+1] to q[i+3], so they must be what is already there)
+    static void scatter(int *p,Mask m,Ints i,Ints a) { _mm512_mask_i32scatter_epi32((void*)p,m,i,a,4); }
+    static void scatter_bytes(unsigned char *q,Mask m,Ints i,Ints a) { _mm512_mask_i32scatter_epi32((void*)q,m,i,a,1); }
+};
+#elif defined(__AVX2__)
+struct BatchLanes
+{
+    static const int N = 8;
+    typedef __m256i Ints;
+    typedef __m256i Mask; // (all bits set in the lanes of the set)
+
+    static const char *name() { return "avx2"; }
+
+    static Ints set(int a) { return _mm256_set1_epi32(a); }
+    static Ints load(const int *p) { return _mm256_loadu_si256((const __m256i*)p); }
+    static void store(int *p,Ints a) { _mm256_storeu_si256((__m256i*)p,a); }
+    static Ints add(Ints a,Ints b) { return _mm256_add_epi32(a,b); }
+    static Ints sub(Ints a,Ints b) { return _mm256_sub_epi32(a,b); }
+    static Ints mul(Ints a,Ints b) { return _mm256_mullo_epi32(a,b); }
+    static Ints max(Ints a,Ints b) { return _mm256_max_epi32(a,b); }
+    static Ints bit_and(Ints a,Ints b) { return _mm256_and_si256(a,b); }
+    static Ints bit_or(Ints a,Ints b) { return _mm256_or_si256(a,b); }
+    static Ints bit_xor(Ints a,Ints b) { return _mm256_xor_si256(a,b); }
+    template<int S> static Ints shift_right(Ints a) { return _mm256_srli_epi32(a,S); }
+
+    static Mask eq(Ints a,Ints b) { return _mm256_cmpeq_epi32(a,b); }
+    static Mask both(Mask a,Mask b) { return _mm256_and_si256(a,b); }
+    static Mask either(Mask a,Mask b) { return _mm256_or_si256(a,b); }
+    static Mask except(Mask a,Mask b) { return _mm256_andnot_si256(b,a); }
+    static Mask mask(int bits)
+    {
+        const __m256i lane_bits = _mm256_setr_epi32(1,2,4,8,16,32,64,128);
+        return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(bits),lane_bits),lane_bits);
+    }
+    static int bits(Mask m) { return _mm256_movemask_ps(_mm256_castsi256_ps(m)); }
+    static Ints select(Mask m,Ints a,Ints b) { return _mm256_blendv_epi8(b,a,m); }
+
+    static Ints gather(const int *p,Ints i) { return _mm256_i32gather_epi32(p,i,4); }
+    static Ints gather_bytes(const unsigned char *q,Ints i) { return _mm256_i32gather_epi32((const int*)q,i,1); }
+    // (AVX2 has no scatter)
+    static void scatter(int *p,Mask m,Ints i,Ints a)
+    {
+        int index[N],value[N];
+        const int set = bits(m);
+        store(index,i);
+        store(value,a);
+        for(int iLane=0;iLane<N;iLane++)
+            if(set>>iLane & 1)
+                p[index[iLane]] = value[iLane];
+    }
+    static void scatter_bytes(unsigned char *q,Mask m,Ints i,Ints a)
+    {
+        int index[N],value[N];
+        const int set = bits(m);
+        store(index,i);
+        store(value,a);
+        for(int iLane=0;iLane<N;iLane++)
+            if(set>>iLane & 1)
+                q[index[iLane]] = (unsigned char)value[iLane];
+    }
+};
+#else
+struct BatchLanes
+{
+    static const int N = 8;
+    struct Ints { int v[N]; };
+    typedef Ints Mask; // (-1 in the lanes of the set, 0 in the others)
+
+    static const char *name() { return "portable"; }
+
+    static Ints set(int a) { Ints r; for(int k=0;k<N;k++) r.v[k] = a; return r; }
+    static Ints load(const int *p) { Ints r; for(int k=0;k<N;k++) r.v[k] = p[k]; return r; }
+    static void store(int *p,Ints a) { for(int k=0;k<N;k++) p[k] = a.v[k]; }
+    static Ints add(Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] = (int)((unsigned int)a.v[k]+b.v[k]); return a; }
+    static Ints sub(Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] = (int)((unsigned int)a.v[k]-b.v[k]); return a; }
+    static Ints mul(Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] = (int)((unsigned int)a.v[k]*(unsigned int)b.v[k]); return a; }
+    static Ints max(Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] = a.v[k]>b.v[k] ? a.v[k] : b.v[k]; return a; }
+    static Ints bit_and(Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] &= b.v[k]; return a; }
+    static Ints bit_or(Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] |= b.v[k]; return a; }
+    static Ints bit_xor(Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] ^= b.v[k]; return a; }
+    template<int S> static Ints shift_right(Ints a) { for(int k=0;k<N;k++) a.v[k] = (int)((unsigned int)a.v[k]>>S); return a; }
+
+    static Mask eq(Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] = -(a.v[k]==b.v[k]); return a; }
+    static Mask both(Mask a,Mask b) { return bit_and(a,b); }
+    static Mask either(Mask a,Mask b) { return bit_or(a,b); }
+    static Mask except(Mask a,Mask b) { for(int k=0;k<N;k++) a.v[k] &= ~b.v[k]; return a; }
+    static Mask mask(int bits) { Mask m; for(int k=0;k<N;k++) m.v[k] = -(bits>>k & 1); return m; }
+    static int bits(Mask m) { int r=0; for(int k=0;k<N;k++) r |= (m.v[k] & 1)<<k; return r; }
+    static Ints select(Mask m,Ints a,Ints b) { for(int k=0;k<N;k++) a.v[k] = (a.v[k] & m.v[k]) | (b.v[k] & ~m.v[k]); return a; }
+
+    static Ints gather(const int *p,Ints i) { for(int k=0;k<N;k++) i.v[k] = p[i.v[k]]; return i; }
+    static Ints gather_bytes(const unsigned char *q,Ints i) { for(int k=0;k<N;k++) i.v[k] = q[i.v[k]]; return i; }
+    static void scatter(int *p,Mask m,Ints i,Ints a) { for(int k=0;k<N;k++) if(m.v[k]) p[i.v[k]] = a.v[k]; }
+    static void scatter_bytes(unsigned char *q,Mask m,Ints i,Ints a) { for(int k=0;k<N;k++) if(m.v[k]) q[i.v[k]] = (unsigned char)a.v[k]; }
+};
+#endif
+
+template<class Topology,class Movement,int N_STATES_,int N_COLORS_>
+class BatchEngine
+{
+    typedef BatchLanes L;
+    typedef L::Ints Ints;
+    typedef L::Mask Mask;
+
+    public:
+
+        static const int N_DIM = Topology::N_DIM;
+        static const int N_MOVES = 1+Topology::N_DIRS;
+        static const int LANES = L::N;
+        static const int MAX_ITS = TranslationDetector::FOLLOW_AFTER;
+
+        // whether the grids of every lane, for a dense grid of n_cells, can be numbered with an int
+        static bool fits(unsigned int n_cells) { return n_cells>0 && ((unsigned long long)n_cells+6)*LANES<=0x7fffffff; }
+
+        // R, ITS, n_states and n_colors as for TurmiteEngine (throws std::bad_alloc if the grids
+        // don't fit)
+        BatchEngine(int R,int ITS,int n_states,int n_colors) : engine(R,ITS,n_states,n_colors,0,false),
+            LIMIT(ITS<MAX_ITS ? ITS : MAX_ITS),N_CELLS(engine.n_cells()),STRIDE((N_CELLS+6)&~3u),
+            N_ENTRIES(engine.n_states()*(engine.n_colors()+1)),visit(0)
+        {
+            if(!fits(N_CELLS))
+                throw std::bad_alloc();
+            // every lane's grid starts as a copy of the engine's, with its border, followed by at
+            // least 3 bytes that aren't used (gather_bytes() reads them), and starts at a multiple of 4
+            // so that the parity of the cells is the same as in TurmiteEngine
+            typename Engine::Grid grid;
+            engine.prepare_grid(grid);
+            cells.assign((size_t)LANES*STRIDE,0);
+            for(int iLane=0;iLane<LANES;iLane++)
+                for(unsigned int iCell=0;iCell<N_CELLS;iCell++)
+                    cells[iLane*STRIDE+iCell] = grid[iCell];
+            visited.assign(STRIDE,0);
+            for(int parity=0;parity<N_PARITIES;parity++)
+                for(int facing=0;facing<N_FACINGS;facing++)
+                    for(int move=0;move<N_MOVES;move++)
+                        engine.dense_step(parity,facing,move,step_offset[(parity*N_FACINGS+facing)*N_MOVES+move],
+                            step_dir[(parity*N_FACINGS+facing)*N_MOVES+move]);
+            tables.assign((size_t)LANES*N_ENTRIES,0);
+            written.assign((size_t)LANES*std::max(LIMIT,1),0);
+            old_colors.assign(written.size(),0);
+            for(int iLane=0;iLane<LANES;iLane++)
+            {
+                first_cell[iLane] = iLane*STRIDE + engine.start_cell();
+                table_first[iLane] = iLane*N_ENTRIES;
+                log_first[iLane] = iLane*std::max(LIMIT,1);
+                n_written[iLane] = 0;
+            }
+        }
+
+        int n_states() const { return engine.n_states(); }
+        int n_colors() const { return engine.n_colors(); }
+
+        // the most steps a lane takes: a turmite still running then is reported as TIMED_OUT, and if
+        // this is less than ITS it should be run again with TurmiteEngine
+        int limit() const { return LIMIT; }
+
+        // Runs turmites until next() has no more. next(lane) returns a pointer to the transitions of
+        // the next turmite, to be run in the given lane, or NULL if there are none left. When a
+        // turmite stops, finished(lane,outcome,its,n_nonzero,max_slot) is called, before next() is
+        // called for the same lane (max_slot as in TurmiteState). The turmites finish in a
+        // different order from the one they started in.
+        template<class Next,class Finished>
+        void run(Next next,Finished finished)
+        {
+            const int N_COLORS=n_colors();
+            const Ints zero=L::set(0),one=L::set(1),none=L::set(-1),low_byte=L::set(0xff),colors=L::set(N_COLORS),
+                off_grid=L::set((int)TransitionTable::OFF_GRID),limit=L::set(LIMIT),start_dir=L::set(Movement::START_DIR),
+                first_cell=L::load(this->first_cell),table_first=L::load(this->table_first),log_first=L::load(this->log_first);
+            // the key of (cell,color) for the hash, from cell*N_COLORS (0 for color 0, so that an
+            // empty grid has hash 0)
+            auto key = [&](Ints cell_colors,Ints color) -> Ints
+            {
+                Ints z = L::mul(L::add(cell_colors,color),L::set((int)0x9E3779B1));
+                z = L::mul(L::bit_xor(z,L::shift_right<15>(z)),L::set((int)0x85EBCA6B));
+                z = L::bit_xor(z,L::shift_right<13>(z));
+                return L::select(L::eq(color,zero),zero,z);
+            };
+
+            // the lanes (saved_*, next_save and saved_mark are the cycle detector's, as in
+            // cycle_detection.h, with saved_mark counting the cells written)
+            Ints cell=first_cell,state=zero,dir=start_dir,its=zero,n_nonzero=zero,max_slot=none,hash=zero;
+            Ints n_written=L::load(this->n_written); // (the lanes that aren't filled keep theirs, to be undone later)
+            Ints saved_cell=none,saved_state=zero,saved_dir=zero,saved_hash=zero,next_save=one,saved_mark=zero;
+            // start new turmites in the given lanes, as in TurmiteEngine::start()
+            auto restart = [&](Mask lanes)
+            {
+                cell = L::select(lanes,first_cell,cell);
+                state = L::select(lanes,zero,state); // start in state 0 (symmetry constraint)
+                dir = L::select(lanes,start_dir,dir);
+                its = L::select(lanes,zero,its);
+                n_nonzero = L::select(lanes,zero,n_nonzero);
+                max_slot = L::select(lanes,none,max_slot);
+                hash = L::select(lanes,zero,hash); // the grid is empty
+                n_written = L::select(lanes,zero,n_written);
+                saved_cell = L::select(lanes,none,saved_cell); // nothing to compare against yet
+                next_save = L::select(lanes,one,next_save);
+            };
+            int running=0; // a bit for each lane that holds a turmite
+            for(int iLane=0;iLane<LANES;iLane++)
+                if(fill(iLane,next(iLane)))
+                    running |= 1<<iLane;
+            restart(L::mask(running));
+            Mask active = L::mask(running);
+            while(running)
+            {
+                // the lanes' colors and transitions (the other bytes of word are the next cells')
+                const Ints word = L::gather_bytes(&cells[0],cell);
+                const Ints color = L::bit_and(word,low_byte);
+                const Ints slot = L::add(L::mul(state,colors),color);
+                const Ints transition = L::gather((const int*)&tables[0],L::add(L::add(table_first,slot),state));
+
+                // on the border the last step took the turmite off the grid, else it may have run
+                // out of steps
+                const Mask off = L::both(active,L::eq(transition,off_grid));
+                const Mask timed_out = L::except(L::both(active,L::eq(its,limit)),off);
+                Mask going = L::except(active,L::either(off,timed_out));
+
+                // save the configuration at steps 1,2,4,8,..., and compare it with the others
+                const Mask save = L::both(going,L::eq(its,next_save));
+                saved_cell = L::select(save,cell,saved_cell);
+                saved_state = L::select(save,state,saved_state);
+                saved_dir = L::select(save,dir,saved_dir);
+                saved_hash = L::select(save,hash,saved_hash);
+                saved_mark = L::select(save,n_written,saved_mark);
+                next_save = L::select(save,L::add(next_save,next_save),next_save);
+                const Mask same = L::both(L::except(going,save),L::both(L::both(L::eq(cell,saved_cell),L::eq(hash,saved_hash)),
+                    L::both(L::eq(state,saved_state),L::eq(dir,saved_dir))));
+                int cycled_bits=0;
+                if(L::bits(same))
+                {
+                    // confirm it from the undo log
+                    const int same_bits=L::bits(same);
+                    int mark[LANES];
+                    L::store(mark,saved_mark);
+                    L::store(this->n_written,n_written);
+                    for(int iLane=0;iLane<LANES;iLane++)
+                        if((same_bits>>iLane & 1) && unchanged_since(iLane,mark[iLane]))
+                            cycled_bits |= 1<<iLane;
+                    going = L::except(going,L::mask(cycled_bits));
+                }
+
+                // take the step
+                max_slot = L::select(going,L::max(max_slot,slot),max_slot);
+                const Ints new_color = L::bit_and(transition,low_byte);
+                const Ints move = L::bit_and(L::shift_right<8>(transition),low_byte);
+                const Mask write = L::except(going,L::eq(color,new_color));
+                if(L::bits(write))
+                {
+                    // the cell changes color
+                    const Ints cell_colors = L::mul(cell,colors);
+                    hash = L::select(write,L::bit_xor(hash,L::bit_xor(key(cell_colors,color),key(cell_colors,new_color))),hash);
+                    n_nonzero = L::add(n_nonzero,L::select(L::both(write,L::eq(color,zero)),one,zero));
+                    n_nonzero = L::sub(n_nonzero,L::select(L::both(write,L::eq(new_color,zero)),one,zero));
+                    L::scatter_bytes(&cells[0],write,cell,L::bit_or(L::bit_and(word,L::set(~0xff)),new_color));
+                    const Ints entry = L::add(log_first,n_written);
+                    L::scatter(&written[0],write,entry,cell);
+                    L::scatter(&old_colors[0],write,entry,color);
+                    n_written = L::add(n_written,L::select(write,one,zero));
+                }
+                its = L::add(its,L::select(going,one,zero)); // (a halt step is counted)
+                const Mask halted = L::both(going,L::eq(move,zero));
+                going = L::except(going,halted);
+                // (the border stops the turmite if this takes it off the grid)
+                Ints iStep = move;
+                if(Movement::RELATIVE)
+                    iStep = L::add(iStep,L::mul(dir,L::set(N_MOVES)));
+                if(Topology::STEP_PARITY)
+                    iStep = L::add(iStep,L::mul(L::bit_and(cell,one),L::set(N_FACINGS*N_MOVES)));
+                cell = L::select(going,L::add(cell,L::gather(step_offset,iStep)),cell);
+                if(Movement::RELATIVE)
+                    dir = L::select(going,L::gather(step_dir,iStep),dir);
+                state = L::select(going,L::bit_and(L::shift_right<16>(transition),low_byte),state);
+
+                // report the lanes that have stopped, and refill them
+                const int off_bits=L::bits(off),timed_out_bits=L::bits(timed_out),halted_bits=L::bits(halted);
+                const int stopped_bits = off_bits | timed_out_bits | cycled_bits | halted_bits;
+                if(stopped_bits)
+                {
+                    int n_its[LANES],n_cells[LANES],top_slot[LANES],refilled=0;
+                    L::store(n_its,its);
+                    L::store(n_cells,n_nonzero);
+                    L::store(top_slot,max_slot);
+                    L::store(this->n_written,n_written);
+                    for(int iLane=0;iLane<LANES;iLane++)
+                    {
+                        if(!(stopped_bits>>iLane & 1))
+                            continue;
+                        RunOutcome outcome = HALTED;
+                        if(off_bits>>iLane & 1)
+                        {
+                            outcome = OFF_GRID;
+                            n_its[iLane]--; // (as in TurmiteEngine, the step onto the border isn't counted)
+                        }
+                        else if(timed_out_bits>>iLane & 1)
+                            outcome = TIMED_OUT;
+                        else if(cycled_bits>>iLane & 1)
+                            outcome = CYCLED;
+                        finished(iLane,outcome,n_its[iLane],n_cells[iLane],top_slot[iLane]);
+                        if(fill(iLane,next(iLane)))
+                            refilled |= 1<<iLane;
+                        else
+                            running &= ~(1<<iLane);
+                    }
+                    restart(L::mask(refilled));
+                    active = L::mask(running);
+                }
+            }
+            L::store(this->n_written,n_written);
+        }
+
+    private:
+
+        typedef TurmiteEngine<Topology,Movement,N_STATES_,N_COLORS_> Engine;
+
+        static const int N_PARITIES = Topology::STEP_PARITY ? 2 : 1;
+        static const int N_FACINGS = Movement::RELATIVE ? N_MOVES : 1;
+
+        // undo the writes of the lane's last turmite and give it the transitions of the next one,
+        // returns false if there isn't one
+        bool fill(int iLane,const TransitionTable *transitions)
+        {
+            if(!transitions)
+                return false;
+            for(int iWrite=log_first[iLane];iWrite<log_first[iLane]+n_written[iLane];iWrite++)
+                cells[written[iWrite]] = 0;
+            n_written[iLane] = 0;
+            for(int iEntry=0;iEntry<N_ENTRIES;iEntry++)
+                tables[iLane*N_ENTRIES+iEntry] = (*transitions)[iEntry];
+            return true;
+        }
+
+        // true if every cell of the lane's grid has the same color as when it had written mark cells
+        bool unchanged_since(int iLane,int mark)
+        {
+            // a cell's color at the mark is the old color of its first write since then
+            if(++visit==0)
+            {
+                std::fill(visited.begin(),visited.end(),0);
+                visit = 1;
+            }
+            for(int iWrite=log_first[iLane]+mark;iWrite<log_first[iLane]+n_written[iLane];iWrite++)
+            {
+                const int iCell = written[iWrite];
+                if(visited[iCell-iLane*STRIDE]==visit)
+                    continue;
+                visited[iCell-iLane*STRIDE] = visit;
+                if(cells[iCell]!=old_colors[iWrite])
+                    return false;
+            }
+            return true;
+        }
+
+        const Engine engine; // for the layout of the grid and the moves
+        const int LIMIT;
+        const unsigned int N_CELLS,STRIDE; // each lane's grid starts STRIDE cells after the one before
+        const int N_ENTRIES; // the words of a transition table
+
+        std::vector<unsigned char> cells; // the lanes' grids, one after another
+        std::vector<TransitionTable::Transition> tables; // tables[table_first[iLane]+iSlot+state], laid out as in TransitionTable
+        std::vector<int> written,old_colors; // each lane's undo log: the cells written, from log_first[iLane] on
+        std::vector<unsigned int> visited; // for unchanged_since()
+        unsigned int visit;
+        int step_offset[N_PARITIES*N_FACINGS*N_MOVES],step_dir[N_PARITIES*N_FACINGS*N_MOVES]; // as TurmiteEngine's steps
+
+        // where each lane's start cell, transition table and undo log are, and the length of its log
+        // (the rest of a lane is only held in registers, while run() runs)
+        int first_cell[LANES],table_first[LANES],log_first[LANES],n_written[LANES];
+};
+
+#endif
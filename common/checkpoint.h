@@ -0,0 +1,133 @@
+// Saving and restoring the position of a search, so that a long run can be resumed.
+//
+// Chunks are committed in order (see parallel_search.h), so the position is just the first chunk
+// that hasn't been committed, together with the totals and records at that point and the lengths
+// of the found_*.txt file and of the log of halting machines. A checkpoint is written to a
+// temporary file and then renamed over the old one, so a crash while writing it leaves the
+// previous checkpoint intact. With --stages the chunks are those of the current stage, and the
+// length of its file of held-out machines is saved. With --save-outcomes the length of the file of
+// outcomes is saved too.
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+// stdlib:
+#include <signal.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// STL:
+#include <fstream>
+#include <string>
+
+struct Checkpoint
+{
+    std::string parameters; // describes the search, which must be the same when resuming
+    int chunking; // the chunks were laid out for this number of threads
+    unsigned long long next_chunk; // every chunk before this one has been committed
+    unsigned long long tried,tested;
+    unsigned long long n_unreachable; // machines not tested because they can never halt
+    unsigned long long n_off_grid,n_cycled,n_timed_out;
+    int max_its,max_nonzero;
+    unsigned long long found_size; // the length of the found_*.txt file
+    unsigned long long log_size; // the length of the found_*.jsonl file (0 if there isn't one)
+    int stage; // with --stages: the stage being searched, counting from 0
+    unsigned long long held_out_size; // the length of the stage's file of held-out machines (0 without --stages)
+    unsigned long long outcomes_size; // the length of the file of outcomes (0 without --save-outcomes)
+};
+
+inline bool save_checkpoint(const std::string& filename,const Checkpoint& c)
+{
+    const std::string temp_filename = filename+".tmp";
+    {
+        std::ofstream out(temp_filename.c_str());
+        out << c.parameters << "\n" << c.chunking << " " << c.next_chunk << "\n"
+            << c.tried << " " << c.tested << "\n"
+            << c.n_off_grid << " " << c.n_cycled << " " << c.n_timed_out << "\n"
+            << c.max_its << " " << c.max_nonzero << "\n" << c.found_size << " " << c.log_size << "\n"
+            << c.stage << " " << c.held_out_size << "\n" << c.n_unreachable << " " << c.outcomes_size << "\n";
+        out.flush();
+        if(!out)
+            return false;
+    }
+#ifdef _WIN32
+    remove(filename.c_str()); // rename won't replace an existing file
+#endif
+    return rename(temp_filename.c_str(),filename.c_str())==0;
+}
+
+inline bool load_checkpoint(const std::string& filename,Checkpoint& c)
+{
+    std::ifstream in(filename.c_str());
+    if(!std::getline(in,c.parameters))
+        return false;
+    in >> c.chunking >> c.next_chunk >> c.tried >> c.tested >> c.n_off_grid >> c.n_cycled
+        >> c.n_timed_out >> c.max_its >> c.max_nonzero >> c.found_size;
+    if(in.fail())
+        return false;
+    if(!(in >> c.log_size))
+        c.log_size = 0; // (saved before there was a log)
+    if(!(in >> c.stage >> c.held_out_size))
+    {
+        c.stage = 0; // (saved before there were stages)
+        c.held_out_size = 0;
+    }
+    if(!(in >> c.n_unreachable))
+        c.n_unreachable = 0; // (saved before machines were pruned)
+    if(!(in >> c.outcomes_size))
+        c.outcomes_size = 0; // (saved before outcomes were)
+    return true;
+}
+
+// cut a file back to its first n_bytes, dropping anything written after the checkpoint (in place,
+// so that the file of outcomes, which can run to gigabytes, isn't read or copied)
+inline bool truncate_file(const std::string& filename,unsigned long long n_bytes)
+{
+#ifdef _WIN32
+    struct _stat64 info;
+    const bool found = _stat64(filename.c_str(),&info)==0;
+#else
+    struct stat info;
+    const bool found = stat(filename.c_str(),&info)==0;
+#endif
+    if(!found)
+        return n_bytes==0 && std::ofstream(filename.c_str(),std::ios::binary); // (an empty file)
+    if((unsigned long long)info.st_size<n_bytes)
+        return false;
+#ifdef _WIN32
+    const int fd = _open(filename.c_str(),_O_RDWR|_O_BINARY);
+    if(fd<0)
+        return false;
+    const bool done = _chsize_s(fd,(__int64)n_bytes)==0;
+    _close(fd);
+    return done;
+#else
+    return truncate(filename.c_str(),(off_t)n_bytes)==0;
+#endif
+}
+
+// set by SIGINT or SIGTERM
+inline volatile sig_atomic_t& stop_flag()
+{
+    static volatile sig_atomic_t flag = 0;
+    return flag;
+}
+
+inline void handle_stop_signal(int) { stop_flag() = 1; }
+
+// after this, SIGINT and SIGTERM ask the search to stop instead of killing it
+inline void install_stop_handlers()
+{
+    signal(SIGINT,handle_stop_signal);
+    signal(SIGTERM,handle_stop_signal);
+}
+
+inline bool stop_requested() { return stop_flag()!=0; }
+
+#endif
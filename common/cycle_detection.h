@@ -0,0 +1,77 @@
+// Exact detection of turmites that repeat a configuration.
+//
+// A turmite that returns to an earlier configuration (the same cell colors, position, state and
+// direction) will go round the same loop forever, so we can stop it there instead of running it to
+// ITS steps. The cell colors are summarized by a Zobrist hash, updated with two XORs whenever a
+// cell changes color. Following Brent, the configuration is saved at steps 1,2,4,8,... and every
+// later step is compared against it, which finds any cycle within a few times its length plus the
+// steps before it. A matching hash is confirmed against the journal of the grid, so a collision
+// can never cause a turmite to be rejected.
+
+#ifndef CYCLE_DETECTION_H
+#define CYCLE_DETECTION_H
+
+// local:
+#include "journal_grid.h"
+
+// The key of each (cell,color) is computed when it is needed, by mixing the bits of the two, so
+// that grids whose cells are allocated as they are reached (see journal_grid.h) need no table.
+class ZobristKeys
+{
+    public:
+
+        explicit ZobristKeys(int n_colors) : n_colors(n_colors) {}
+
+        unsigned long long operator()(unsigned int iCell,unsigned char color) const
+        {
+            // (the finalizer of splitmix64)
+            unsigned long long z = (unsigned long long)iCell*n_colors + color + 0x9E3779B97F4A7C15ULL;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            return color==0 ? 0 : z; // an empty grid has hash 0
+        }
+
+    private:
+
+        int n_colors;
+};
+
+class CycleDetector
+{
+    public:
+
+        void reset()
+        {
+            next_save = 1;
+            saved_cell = -1; // nothing to compare against yet
+        }
+
+        // Call once for every step, with the configuration before the step is taken. Returns true
+        // if the configuration is the same as at an earlier step.
+        template<class Grid>
+        bool repeated(int its,unsigned long long hash,int iCell,int state,int dir,Grid &grid)
+        {
+            if(its==next_save)
+            {
+                saved_hash = hash;
+                saved_cell = iCell;
+                saved_state = state;
+                saved_dir = dir;
+                saved_mark = grid.mark();
+                next_save *= 2;
+                return false;
+            }
+            return hash==saved_hash && iCell==saved_cell && state==saved_state && dir==saved_dir
+                && grid.unchanged_since(saved_mark);
+        }
+
+    private:
+
+        long long next_save; // the step at which to save the configuration next (it can pass INT_MAX)
+        unsigned long long saved_hash;
+        int saved_cell,saved_state,saved_dir;
+        size_t saved_mark;
+};
+
+#endif
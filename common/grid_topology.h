@@ -0,0 +1,298 @@
+// The grids that turmites can live on, and the two ways they can move.
+//
+// A topology says how the cells are numbered, where each direction leads and how a turn changes
+// the direction. Directions and turns are numbered from 1, with 0 meaning halt. Cells are
+// addressed by coordinates in [0,SIDE) along each of the N_DIM axes. A move changes each
+// coordinate by at most 1, so step() can leave the checking to a border of cells one wide around
+// the grid (see turmite_engine.h); move() checks for itself. Where step() takes a cell depends only
+// on the direction, and on the grids with STEP_PARITY also on whether x+y+... is odd.
+//
+// Each topology also lists the symmetries of its grid that can be used to cut down the search (see
+// symmetry.h), as permutations of the moves: the reflections and rotations that keep the start cell
+// where it is and map the block of cells onto itself (so that a turmite leaves the grid just when
+// its image does), and that for relative turmites keep the starting direction. The first is the
+// identity.
+//
+// A movement policy says how a move in the transition table becomes a direction: an absolute
+// turmite's move is the direction itself, a relative turmite's move is a turn made relative to the
+// direction it last moved in.
+
+#ifndef GRID_TOPOLOGY_H
+#define GRID_TOPOLOGY_H
+
+// STL:
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
+
+typedef std::vector<std::vector<unsigned char> > MoveSymmetries; // moves[move] for each symmetry
+
+// N-dimensional square grid (a line, squares, cubes, ...): two directions along each axis
+template<int N_DIM_>
+struct SquareTopology
+{
+    static const int N_DIM = N_DIM_;
+    static const int N_DIRS = 2*N_DIM; // 1=+X, 2=-X, 3=+Y, 4=-Y, ...
+
+    // The difficulty lies in the turmite orientation. In 1D and 2D we only need store which
+    // direction the turmite last moved in, this is sufficient to determine its orientation. In
+    // 3D, however, we also need a twist orientation: an airplane flying north that turns right will
+    // be travelling east if it's flying the right way up, west if it's flying upside-down. In
+    // general we need D-1 values for dimensions D>1 (I think?) and my brain hurts when I try to
+    // visualise this.
+    static const bool SUPPORTS_RELATIVE = (N_DIM<=2);
+    static const bool SUPPORTS_ABSOLUTE = true;
+    static const bool STEP_PARITY = false;
+
+    static std::string name() { return ""; }
+    // what the radius R counts, for the messages
+    static std::string radius_unit() { return "squares"; }
+
+    // moves one cell in direction dir
+    static void step(int *pos,int dir)
+    {
+        const int axis = (dir-1)/2, delta = (dir&1) ? 1 : -1;
+        for(int iDim=0;iDim<N_DIM;iDim++)
+            pos[iDim] += (iDim==axis) ? delta : 0;
+    }
+
+    // moves one cell in direction dir, returns false if that leaves the grid
+    static bool move(int *pos,int dir,int SIDE)
+    {
+        // (a loop over the axes rather than pos[axis], so that the compiler can unroll it and keep
+        // the position in registers)
+        const int axis = (dir-1)/2, step = (dir&1) ? 1 : -1;
+        for(int iDim=0;iDim<N_DIM;iDim++)
+        {
+            pos[iDim] += (iDim==axis) ? step : 0;
+            if(pos[iDim]<0 || pos[iDim]>=SIDE)
+                return false;
+        }
+        return true;
+    }
+
+    // whether the cell at pos is on the grid
+    static bool contains(const int *pos,int SIDE)
+    {
+        for(int iDim=0;iDim<N_DIM;iDim++)
+            if(pos[iDim]<0 || pos[iDim]>=SIDE)
+                return false;
+        return true;
+    }
+
+    static int turn(int dir,int turn)
+    {
+        static const int DIR_AFTER_TURN[5][5] = // new_dir = DIR_AFTER_TURN[old_dir][turn]
+            {{0,0,0,0,0},{0,1,2,4,3},{0,2,1,3,4},{0,3,4,1,2},{0,4,3,2,1}};
+        return DIR_AFTER_TURN[dir][turn];
+    }
+
+    static std::string move_text(int move,bool relative)
+    {
+        // for output, what is the label for each direction
+        static const char *DIR_TEXT_KNOWN_ABSOLUTE[7] = {"''","'E'","'W'","'N'","'S'","'U'","'D'"};
+        // for output, what is the label for each turn (Ed Pegg Jr.'s Turmite notation)
+        static const char *DIR_TEXT_KNOWN_RELATIVE[5] = {"0","1","4","2","8"}; // 0=halt, 1=noturn, 4=u-turn, 2=right, 8=left (Ed Pegg's notation, we output for Turmite-gen.py)
+        if(relative)
+            return DIR_TEXT_KNOWN_RELATIVE[move];
+        if(move<7)
+            return DIR_TEXT_KNOWN_ABSOLUTE[move];
+        // for 4D etc. we just label the 'compass directions' as "4+", "4-", "5+", "5-", etc.
+        std::ostringstream oss;
+        oss << (move-1)/2+1 << ((move&1) ? "+" : "-");
+        return oss.str();
+    }
+
+    // relative: the reflection that swaps left and right turns (in 2D), absolute: every way of
+    // permuting the axes and reversing some of them (in 4D and up only the reversals, to keep the
+    // number down)
+    static MoveSymmetries move_symmetries(bool relative)
+    {
+        MoveSymmetries symmetries;
+        if(relative)
+        {
+            std::vector<unsigned char> moves(1+N_DIRS);
+            for(int move=0;move<=N_DIRS;move++)
+                moves[move] = (unsigned char)move;
+            symmetries.push_back(moves);
+            if(N_DIM==2)
+            {
+                std::swap(moves[3],moves[4]); // right and left
+                symmetries.push_back(moves);
+            }
+            return symmetries;
+        }
+        std::vector<int> axis(N_DIM); // each axis goes to axis[iAxis], reversed if its bit of flips is set
+        for(int iAxis=0;iAxis<N_DIM;iAxis++)
+            axis[iAxis] = iAxis;
+        do
+        {
+            for(int flips=0;flips<(1<<N_DIM);flips++)
+            {
+                std::vector<unsigned char> moves(1+N_DIRS,0);
+                for(int iAxis=0;iAxis<N_DIM;iAxis++)
+                {
+                    const int flip = (flips>>iAxis)&1;
+                    moves[1+2*iAxis] = (unsigned char)(1+2*axis[iAxis]+flip);
+                    moves[2+2*iAxis] = (unsigned char)(2+2*axis[iAxis]-flip);
+                }
+                symmetries.push_back(moves);
+            }
+        } while(N_DIM<=3 && std::next_permutation(axis.begin(),axis.end()));
+        return symmetries;
+    }
+};
+
+// hexagonal grid, stored as a 2D array with each row shifted half a cell from the one before (so the
+// block of cells is a rhombus)
+struct HexTopology
+{
+    static const int N_DIM = 2;
+    static const int N_DIRS = 6;
+    static const bool SUPPORTS_RELATIVE = true;
+    static const bool SUPPORTS_ABSOLUTE = true;
+    static const bool STEP_PARITY = false;
+
+    static std::string name() { return "hex_"; }
+    // what the radius R counts, for the messages
+    static std::string radius_unit() { return "cells along an axis"; }
+
+    static void step(int *pos,int dir)
+    {
+        static const int DIRS[7][2] = {{0,0},{0,-1},{1,-1},{1,0},{0,1},{-1,1},{-1,0}}; // 0=halt, then following Golly, we skip SE and NW
+        pos[0] += DIRS[dir][0];
+        pos[1] += DIRS[dir][1];
+    }
+
+    static bool move(int *pos,int dir,int SIDE)
+    {
+        step(pos,dir);
+        return contains(pos,SIDE);
+    }
+
+    static bool contains(const int *pos,int SIDE)
+    {
+        return pos[0]>=0 && pos[0]<SIDE && pos[1]>=0 && pos[1]<SIDE;
+    }
+
+    static int turn(int dir,int turn)
+    {
+        static const int DIR_AFTER_TURN[7][7] = // new_dir = DIR_AFTER_TURN[turn][old_dir]
+            {{0,0,0,0,0,0,0},{0,1,2,3,4,5,6},{0,6,1,2,3,4,5},{0,2,3,4,5,6,1},{0,5,6,1,2,3,4},
+            {0,3,4,5,6,1,2},{0,4,5,6,1,2,3}};
+        return DIR_AFTER_TURN[turn][dir];
+    }
+
+    static std::string move_text(int move,bool relative)
+    {
+        // for output, what is the label for each direction
+        static const char *DIR_TEXT_ABSOLUTE[7] = {"''","'A'","'B'","'C'","'D'","'E'","'F'"};
+        // for output, what is the label for each turn
+        static const char *TURN_TEXT_RELATIVE[7] =
+            {"0","1","2","4","8","16","32"}; // 0=halt, 1=noturn, 2=left, 4=right, 8=back-left, 16=back-right, 32=u-turn
+        return relative ? TURN_TEXT_RELATIVE[move] : DIR_TEXT_ABSOLUTE[move];
+    }
+
+    // The rhombus only maps onto itself under the half turn and the reflections across its
+    // diagonals (swapping x and y, and x and -y), of which none keeps the starting direction of a
+    // relative turmite. So absolute turmites get those four, and relative turmites none.
+    static MoveSymmetries move_symmetries(bool relative)
+    {
+        static const unsigned char MOVES[4][7] = {{0,1,2,3,4,5,6},{0,4,5,6,1,2,3},{0,6,5,4,3,2,1},{0,3,2,1,6,5,4}};
+        MoveSymmetries symmetries;
+        for(int i=0;i<(relative ? 1 : 4);i++)
+            symmetries.push_back(std::vector<unsigned char>(MOVES[i],MOVES[i]+7));
+        return symmetries;
+    }
+};
+
+// triangular grid: the triangle at (x,y) points up if x+y is even, down if it is odd, and each
+// triangle has three neighbours, across each of its edges
+struct TriTopology
+{
+    static const int N_DIM = 2;
+    static const int N_DIRS = 3;
+    static const bool SUPPORTS_RELATIVE = true;
+    static const bool SUPPORTS_ABSOLUTE = false; // (the direction would depend on which way the triangle points)
+    static const bool STEP_PARITY = true; // (which way the triangle points)
+
+    static std::string name() { return "tri_"; }
+    // what the radius R counts, for the messages
+    static std::string radius_unit() { return "cells along an axis"; }
+
+    static void step(int *pos,int dir)
+    {
+        static const int DELTA[2][4][2] = // dx,dy = DELTA[pointing down][dir]
+            { {{0,0},{0,1},{-1,0},{1,0}},
+              {{0,0},{0,-1},{1,0},{-1,0}} };
+        const int down = (pos[0]+pos[1])&1;
+        pos[0] += DELTA[down][dir][0];
+        pos[1] += DELTA[down][dir][1];
+    }
+
+    static bool move(int *pos,int dir,int SIDE)
+    {
+        step(pos,dir);
+        return contains(pos,SIDE);
+    }
+
+    static bool contains(const int *pos,int SIDE)
+    {
+        return pos[0]>=0 && pos[0]<SIDE && pos[1]>=0 && pos[1]<SIDE;
+    }
+
+    static int turn(int dir,int turn)
+    {
+        static const int DIR_AFTER_TURN[4][4] = // new_dir = DIR_AFTER_TURN[old_dir][turn]
+            {{0,0,0,0},{0,3,2,1},{0,1,3,2},{0,2,1,3}};
+        return DIR_AFTER_TURN[dir][turn];
+    }
+
+    static std::string move_text(int move,bool)
+    {
+        static const char *TURN_TEXT[4] = {"0","2","1","4"}; // 0=halt, 1=right, 2=left, 3=u-turn
+        return TURN_TEXT[move];
+    }
+
+    // the reflection across the start triangle's axis, which swaps left and right turns
+    static MoveSymmetries move_symmetries(bool)
+    {
+        static const unsigned char MOVES[2][4] = {{0,1,2,3},{0,2,1,3}};
+        MoveSymmetries symmetries;
+        for(int i=0;i<2;i++)
+            symmetries.push_back(std::vector<unsigned char>(MOVES[i],MOVES[i]+4));
+        return symmetries;
+    }
+};
+
+// absolute turmites (Turing machines): the move is the direction to go in
+struct AbsoluteMovement
+{
+    static const bool RELATIVE = false;
+    static std::string name() { return "absolute_"; }
+    static const int START_DIR = 0; // (not used)
+
+    template<class Topology>
+    static int direction(int,int move) { return move; }
+};
+
+// relative turmites ("TurNing machines"): the move is a turn, relative to the last direction moved
+struct RelativeMovement
+{
+    static const bool RELATIVE = true;
+    static std::string name() { return "relative_"; }
+    static const int START_DIR = 1; // starting orientation (arbitrary)
+
+    template<class Topology>
+    static int direction(int dir,int move) { return Topology::turn(dir,move); }
+};
+
+// whether turmites with this movement can live on this grid
+template<class Topology,class Movement>
+struct MovementSupported
+{
+    static const bool value = Movement::RELATIVE ? Topology::SUPPORTS_RELATIVE : Topology::SUPPORTS_ABSOLUTE;
+};
+
+#endif
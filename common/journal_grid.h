@@ -0,0 +1,360 @@
+// A grid of cell colors that keeps an undo log of every write.
+//
+// Most turmites halt or leave the grid after a few steps, so clearing the whole grid for each one
+// costs far more than running it. Instead we undo the writes: the cost of a reset is proportional
+// to the number of steps taken rather than to the number of cells. The log can also be rolled back
+// part of the way, to return to an earlier configuration, or read for the colors the cells had then.
+//
+// The cells are either a fixed block (resize()) or allocated in tiles as they are first needed
+// (use_tiles(), for unbounded grids). A tile is found by a key that the caller makes from its
+// coordinates (see turmite_engine.h), through a small direct-mapped cache of recently used tiles
+// in front of the full directory. Tiles stay allocated from one turmite to the next, so a turmite
+// that stays near the start touches only a few of them. A memory budget is counted for each turmite
+// on its own: it is charged for every tile it reaches, whichever turmite allocated it, so that how
+// far it gets doesn't depend on the ones run before it on the grid. The first time it reaches a
+// tile is noted in the undo log, so that rolling back gives the tile back, and clear() frees the
+// tiles once they take up more than half the budget, or KEPT_CELLS. Without a budget a turmite is
+// still held to MAX_TILED_CELLS, so that the cells of the earlier turmites and its own can always
+// be numbered with an int.
+//
+// The cells can be packed CELL_BITS to a byte: 1 bit for 2 colors, 2 bits for 3 or 4, else a whole
+// byte. A smaller grid stays in the faster caches (a 3D grid of radius 20 takes 67KB as bytes but
+// 8KB as bits), for a few extra instructions on each read and write.
+
+#ifndef JOURNAL_GRID_H
+#define JOURNAL_GRID_H
+
+// STL:
+#include <unordered_map>
+#include <vector>
+
+// the fewest bits per cell that hold N_COLORS colors (8 if N_COLORS is only known at run time, 0)
+template<int N_COLORS>
+struct CellBits
+{
+    static const int value = N_COLORS==2 ? 1 : N_COLORS==3 || N_COLORS==4 ? 2 : 8;
+};
+
+template<int CELL_BITS_>
+class BasicJournalGrid
+{
+    static_assert(CELL_BITS_==1 || CELL_BITS_==2 || CELL_BITS_==8,"cells must be 1, 2 or 8 bits");
+
+    public:
+
+        static const int CELL_BITS = CELL_BITS_;
+        static const unsigned int NO_TILE = 0xffffffff; // returned by tile() when over the memory budget
+        static const unsigned long long MAX_TILED_CELLS = 1ULL<<30; // the most cells a turmite can reach, whatever the budget
+
+        BasicJournalGrid() : n_cells(0),visit(0),tile_cells(0),max_cells(0) { drop_tiles(); }
+
+        // all cells start with color 0
+        void resize(unsigned int n_cells)
+        {
+            this->n_cells = n_cells;
+            cells.assign(bytes_for(n_cells),0);
+            journal.clear();
+            tile_cells = 0;
+        }
+
+        // Start with no cells, and allocate them in tiles of n_tile_cells as tile() asks for them. A
+        // turmite can't reach tiles of more than max_cells cells (or MAX_TILED_CELLS, if that is
+        // fewer or max_cells is 0).
+        void use_tiles(unsigned int n_tile_cells,unsigned long long max_cells)
+        {
+            tile_cells = n_tile_cells;
+            this->max_cells = MAX_TILED_CELLS;
+            if(max_cells && max_cells<MAX_TILED_CELLS)
+                this->max_cells = max_cells;
+            drop_tiles();
+        }
+
+        unsigned int size() const { return n_cells; }
+
+        unsigned char operator[](unsigned int iCell) const
+        {
+            if(CELL_BITS==8)
+                return cells[iCell];
+            return (cells[iCell/CELLS_PER_BYTE] >> (iCell%CELLS_PER_BYTE*CELL_BITS)) & CELL_MASK;
+        }
+
+        void set(unsigned int iCell,unsigned char color)
+        {
+            change(iCell,(*this)[iCell],color);
+        }
+
+        // as set(), when the caller already knows the cell's color
+        void change(unsigned int iCell,unsigned char old_color,unsigned char color)
+        {
+            Write write = { iCell, old_color };
+            journal.push_back(write);
+            if(CELL_BITS==8)
+                cells[iCell] = color;
+            else
+                cells[iCell/CELLS_PER_BYTE] ^= (unsigned char)((old_color^color) << (iCell%CELLS_PER_BYTE*CELL_BITS));
+        }
+
+        // sets a cell without logging the write, so that clear() leaves it alone (for the cells that
+        // never change, such as the border of a dense grid)
+        void fix(unsigned int iCell,unsigned char color)
+        {
+            if(CELL_BITS==8)
+                cells[iCell] = color;
+            else
+            {
+                const int shift = iCell%CELLS_PER_BYTE*CELL_BITS;
+                cells[iCell/CELLS_PER_BYTE] = (unsigned char)((cells[iCell/CELLS_PER_BYTE] & ~(CELL_MASK<<shift)) | color<<shift);
+            }
+        }
+
+        // the first cell of the tile with the given key, allocating it if it is new (or NO_TILE if
+        // the turmite would go over the memory budget by reaching it)
+        unsigned int tile(unsigned long long key)
+        {
+            // (only tiles that the turmite has been charged for are cached)
+            TileCacheEntry &entry = tile_cache[cache_index(key)];
+            if(entry.key==key)
+                return entry.first_cell;
+            unsigned int first_cell;
+            std::unordered_map<unsigned long long,unsigned int>::const_iterator found = directory.find(key);
+            const bool charge = found==directory.end() || !charged[found->second/tile_cells];
+            if(charge && n_charged+tile_cells>max_cells)
+                return NO_TILE;
+            if(found!=directory.end())
+                first_cell = found->second;
+            else
+            {
+                // (clear() leaves at most KEPT_CELLS, so with the turmite's own they stay below REACHED)
+                first_cell = n_cells;
+                n_cells += tile_cells;
+                cells.resize(bytes_for(n_cells),0); // (tiles are a whole number of bytes)
+                directory[key] = first_cell;
+                tile_keys.push_back(key);
+                charged.push_back(0);
+            }
+            if(charge)
+            {
+                charged[first_cell/tile_cells] = 1;
+                n_charged += tile_cells;
+                Write reached = { first_cell | REACHED, 0 };
+                journal.push_back(reached);
+            }
+            entry.key = key;
+            entry.first_cell = first_cell;
+            return first_cell;
+        }
+
+        // the first cell of the tile with the given key, or NO_TILE if it hasn't been allocated (which
+        // this doesn't do)
+        unsigned int find_tile(unsigned long long key) const
+        {
+            std::unordered_map<unsigned long long,unsigned int>::const_iterator found = directory.find(key);
+            return found==directory.end() ? NO_TILE : found->second;
+        }
+
+        // calls f(key,first_cell) for every tile allocated
+        template<class F>
+        void for_each_tile(F f) const
+        {
+            for(std::unordered_map<unsigned long long,unsigned int>::const_iterator it=directory.begin();it!=directory.end();it++)
+                f(it->first,it->second);
+        }
+
+        // the key of the tile that holds a cell
+        unsigned long long tile_key(unsigned int iCell) const { return tile_keys[iCell/tile_cells]; }
+
+        // calls f(iCell) for every write in the undo log, oldest first (a cell can come many times)
+        template<class F>
+        void for_each_write(F f) const
+        {
+            for(size_t iWrite=0;iWrite<journal.size();iWrite++)
+                if(!(journal[iWrite].iCell & REACHED))
+                    f(journal[iWrite].iCell);
+        }
+
+        // calls f(iCell,color) once for every cell written since the grid was cleared, with the color
+        // it had when mark() returned the given value, until f returns false; returns the number of
+        // cells that f was called for
+        template<class F>
+        size_t for_each_written_cell(size_t mark,F f)
+        {
+            // (a cell's color at the mark is the old color of its first write since then, if any)
+            size_t n_cells=0;
+            next_visit();
+            for(size_t iWrite=mark;iWrite<journal.size();iWrite++)
+            {
+                const Write &write = journal[iWrite];
+                if((write.iCell & REACHED) || visited[write.iCell]==visit)
+                    continue;
+                visited[write.iCell] = visit;
+                n_cells++;
+                if(!f(write.iCell,write.old_color))
+                    return n_cells;
+            }
+            for(size_t iWrite=0;iWrite<mark;iWrite++)
+            {
+                const unsigned int iCell = journal[iWrite].iCell;
+                if((iCell & REACHED) || visited[iCell]==visit)
+                    continue;
+                visited[iCell] = visit;
+                n_cells++;
+                if(!f(iCell,(*this)[iCell]))
+                    return n_cells;
+            }
+            return n_cells;
+        }
+
+        // the current position in the undo log
+        size_t mark() const { return journal.size(); }
+
+        // undo every write made since mark() returned the given value (and give back the tiles
+        // reached since then)
+        void rollback(size_t mark)
+        {
+            if(!tile_cells)
+            {
+                while(journal.size()>mark)
+                {
+                    put(journal.back().iCell,journal.back().old_color);
+                    journal.pop_back();
+                }
+                return;
+            }
+            while(journal.size()>mark)
+            {
+                const Write &write = journal.back();
+                if(write.iCell & REACHED)
+                    uncharge((write.iCell & ~REACHED)/tile_cells);
+                else
+                    put(write.iCell,write.old_color);
+                journal.pop_back();
+            }
+        }
+
+        // return every cell to color 0 (and free the tiles if they take up more than half the
+        // memory budget, or more than KEPT_CELLS)
+        void clear()
+        {
+            rollback(0);
+            if(tile_cells && (n_cells>max_cells/2 || n_cells>KEPT_CELLS))
+                drop_tiles();
+        }
+
+        // true if every cell has the same color as when mark() returned the given value
+        bool unchanged_since(size_t mark)
+        {
+            // a cell's color at the mark is the old color of its first write since then
+            next_visit();
+            for(size_t iWrite=mark;iWrite<journal.size();iWrite++)
+            {
+                const Write &write = journal[iWrite];
+                if((write.iCell & REACHED) || visited[write.iCell]==visit)
+                    continue;
+                visited[write.iCell] = visit;
+                if((*this)[write.iCell]!=write.old_color)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+
+        static const unsigned int CELLS_PER_BYTE = 8/CELL_BITS;
+        // In the journal, iCell|REACHED isn't a write but notes that the turmite was charged for the
+        // tile that starts at iCell. (The cells are numbered below it, see tile().)
+        static const unsigned int REACHED = 0x80000000;
+        static const unsigned int CELL_MASK = (1u<<CELL_BITS)-1;
+
+        static size_t bytes_for(unsigned int n_cells) { return ((size_t)n_cells+CELLS_PER_BYTE-1)/CELLS_PER_BYTE; }
+
+        // starts a new pass over the cells: none of them has visited[iCell]==visit
+        void next_visit()
+        {
+            if(visited.size()!=n_cells)
+                visited.assign(n_cells,0);
+            if(++visit==0)
+            {
+                visited.assign(n_cells,0);
+                visit = 1;
+            }
+        }
+
+        // write a cell without logging it
+        void put(unsigned int iCell,unsigned char color)
+        {
+            if(CELL_BITS==8)
+                cells[iCell] = color;
+            else
+            {
+                const unsigned int shift = iCell%CELLS_PER_BYTE*CELL_BITS;
+                unsigned char &byte = cells[iCell/CELLS_PER_BYTE];
+                byte = (unsigned char)((byte & ~(CELL_MASK<<shift)) | (color<<shift));
+            }
+        }
+
+        struct Write
+        {
+            unsigned int iCell;
+            unsigned char old_color;
+        };
+
+        struct TileCacheEntry
+        {
+            unsigned long long key;
+            unsigned int first_cell;
+        };
+
+        static unsigned int cache_index(unsigned long long key)
+        {
+            return (unsigned int)((key*0x9E3779B97F4A7C15ULL)>>(64-TILE_CACHE_BITS));
+        }
+
+        // gives back a tile that the turmite was charged for
+        void uncharge(unsigned int iTile)
+        {
+            charged[iTile] = 0;
+            n_charged -= tile_cells;
+            TileCacheEntry &entry = tile_cache[cache_index(tile_keys[iTile])];
+            if(entry.key==tile_keys[iTile])
+                entry.key = ~0ULL; // (so that tile() charges for it again)
+        }
+
+        void drop_tiles()
+        {
+            n_cells = 0;
+            cells.clear();
+            journal.clear();
+            visited.clear();
+            directory.clear();
+            tile_keys.clear();
+            charged.clear();
+            n_charged = 0;
+            for(int iEntry=0;iEntry<TILE_CACHE_SIZE;iEntry++)
+                tile_cache[iEntry].key = ~0ULL; // (not the key of any tile)
+        }
+
+        unsigned int n_cells;
+        std::vector<unsigned char> cells; // CELLS_PER_BYTE cells in each, the first in the lowest bits
+        std::vector<Write> journal; // oldest first
+
+        // for unchanged_since() and for_each_written_cell(): the cells already seen in the current
+        // call have visited[iCell]==visit
+        std::vector<unsigned int> visited;
+        unsigned int visit;
+
+        // for tiled grids
+        static const int TILE_CACHE_BITS = 6;
+        static const int TILE_CACHE_SIZE = 1<<TILE_CACHE_BITS;
+        static const unsigned int KEPT_CELLS = 1u<<24; // clear() frees the tiles once there are more cells than this
+        unsigned int tile_cells; // 0 if the grid isn't tiled
+        unsigned long long max_cells; // the most cells of tiles a turmite can reach
+        std::unordered_map<unsigned long long,unsigned int> directory; // the first cell of each tile, by key
+        std::vector<unsigned long long> tile_keys; // the key of each tile, in the order they were allocated
+        std::vector<unsigned char> charged; // whether the turmite was charged for each tile
+        unsigned long long n_charged; // the cells of those tiles
+        TileCacheEntry tile_cache[TILE_CACHE_SIZE];
+};
+
+typedef BasicJournalGrid<8> JournalGrid; // a byte for each cell, for any number of colors
+
+#endif
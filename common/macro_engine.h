@@ -0,0 +1,465 @@
+// Running long-lived turmites many steps at a time.
+//
+// A turmite that runs for millions of steps spends most of them going over the same patterns again
+// and again: sweeping back and forth across a growing block, or building a highway. Here the grid
+// is cut into tiles that each fit in a 64-bit word (1D: 64 cells for 2 colors, 2D: 8x8, 3D: 4x4x4,
+// smaller tiles for more colors). What happens from the moment the turmite enters a tile until it
+// leaves - the tile's new contents, where it leaves and in which state, how many steps that took
+// and the change in population - depends only on the tile's contents and on the turmite's cell,
+// state and direction in it. That "transit" is worked out once, a step at a time, and after that
+// the turmite crosses the tile in a single lookup whenever it enters it the same way again. (A
+// turmite that stays in one tile is taken MAX_TRANSIT steps at a time.)
+//
+// A turmite that keeps making new patterns gains nothing from the cache, and working out each
+// transit costs more than stepping through it. So every CHECK_EVERY steps the steps worked out are
+// compared with the steps looked up, and if more were worked out the turmite is taken a step at a
+// time for a while: CHECK_EVERY steps, four times as long if it happens again at the next check,
+// and so on.
+//
+// A turmite that halts or moves off the grid stops with the same step count and population as in
+// turmite_engine.h. Cycles are looked for at each transit rather than at each step, so a turmite
+// that repeats a configuration is caught at a different step, and near ITS may be counted as timed
+// out instead or the other way round. Configurations shifted along aren't looked for (see
+// translation_detection.h): a turmite that repeats one runs until it moves off the grid or reaches
+// ITS. Transits are remembered for one turmite at a time (clear() forgets them), whose transition
+// table must be complete, as in the odometer search. Tiles on the edge of the grid, and the last few
+// steps before ITS, are taken one step at a time. The grids are dense (no TILED version).
+
+#ifndef MACRO_ENGINE_H
+#define MACRO_ENGINE_H
+
+// STL:
+#include <vector>
+
+// local:
+#include "grid_topology.h"
+#include "transition_table.h"
+#include "turmite.h"
+#include "turmite_engine.h"
+
+// what a turmite did in a tile, from entering it until it left, halted or took MAX_TRANSIT steps
+struct MacroTransit
+{
+    enum End { LEFT, HALTED, STAYED };
+
+    // the key: the tile's contents and where the turmite entered it (cell | state<<8 | dir<<16)
+    unsigned long long contents;
+    unsigned int entry;
+    unsigned int generation; // the entry only counts if this is the grid's generation
+
+    unsigned long long new_contents;
+    int steps; // including the step that left the tile, or the halt step
+    int nonzero_change;
+    int max_slot; // the highest state*N_COLORS+color read
+    unsigned char cell; // LEFT: the cell it left from, else the cell it is on
+    unsigned char state,dir; // LEFT: the state and direction of the step out of the tile, else the current ones
+    unsigned char end;
+};
+
+// The grid for MacroEngine: a word for each tile, with an undo log as in journal_grid.h, and a cache
+// of the transits worked out for the current turmite.
+class MacroGrid
+{
+    public:
+
+        MacroGrid() : visit(0),generation(1) {}
+
+        // all tiles start empty
+        void resize(unsigned int n_tiles)
+        {
+            tiles.assign(n_tiles,0);
+            journal.clear();
+            transits.assign(1<<TRANSIT_BITS,MacroTransit());
+            for(size_t iTransit=0;iTransit<transits.size();iTransit++)
+                transits[iTransit].generation = 0;
+            generation = 1;
+        }
+
+        unsigned long long operator[](unsigned int iTile) const { return tiles[iTile]; }
+
+        void set(unsigned int iTile,unsigned long long contents)
+        {
+            Write write = { iTile, tiles[iTile] };
+            journal.push_back(write);
+            tiles[iTile] = contents;
+        }
+
+        // The transit for the given key. If it isn't known, found is false and the caller fills it in
+        // (it may push out another one).
+        MacroTransit &transit(unsigned long long contents,unsigned int entry,bool &found)
+        {
+            const unsigned long long mixed = (contents ^ ((unsigned long long)entry<<40 | entry)) * 0x9E3779B97F4A7C15ULL;
+            MacroTransit &transit = transits[mixed>>(64-TRANSIT_BITS)];
+            found = transit.generation==generation && transit.contents==contents && transit.entry==entry;
+            if(!found)
+            {
+                transit.contents = contents;
+                transit.entry = entry;
+                transit.generation = generation;
+            }
+            return transit;
+        }
+
+        // as for JournalGrid
+        size_t mark() const { return journal.size(); }
+
+        // return every tile to empty, and forget the transits (they belong to one transition table)
+        void clear()
+        {
+            while(!journal.empty())
+            {
+                tiles[journal.back().iTile] = journal.back().old_contents;
+                journal.pop_back();
+            }
+            if(++generation==0)
+            {
+                for(size_t iTransit=0;iTransit<transits.size();iTransit++)
+                    transits[iTransit].generation = 0;
+                generation = 1;
+            }
+        }
+
+        // as for JournalGrid
+        bool unchanged_since(size_t mark)
+        {
+            if(visited.size()!=tiles.size())
+                visited.assign(tiles.size(),0);
+            if(++visit==0)
+            {
+                visited.assign(tiles.size(),0);
+                visit = 1;
+            }
+            for(size_t iWrite=mark;iWrite<journal.size();iWrite++)
+            {
+                const Write &write = journal[iWrite];
+                if(visited[write.iTile]==visit)
+                    continue;
+                visited[write.iTile] = visit;
+                if(tiles[write.iTile]!=write.old_contents)
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+
+        static const int TRANSIT_BITS = 16; // the cache holds 1<<TRANSIT_BITS transits
+
+        struct Write
+        {
+            unsigned int iTile;
+            unsigned long long old_contents;
+        };
+
+        std::vector<unsigned long long> tiles; // the cells of a tile in order, COLOR_BITS each, the first in the lowest bits
+        std::vector<Write> journal; // oldest first
+        std::vector<unsigned int> visited; // for unchanged_since()
+        unsigned int visit;
+        std::vector<MacroTransit> transits; // direct-mapped
+        unsigned int generation; // transits from an earlier turmite have an older generation
+};
+
+template<class Topology,class Movement,int N_STATES_,int N_COLORS_>
+class MacroEngine
+{
+    static_assert(MovementSupported<Topology,Movement>::value,
+        "this kind of movement isn't supported on this grid (see grid_topology.h)");
+
+    public:
+
+        static const int N_DIM = Topology::N_DIM;
+        static const int MAX_TRANSIT = 1<<12; // the most steps taken in one lookup
+        static const int CHECK_EVERY = 1<<14; // how often to check that the cache is paying
+
+        typedef MacroGrid Grid;
+
+        // as for TurmiteEngine
+        MacroEngine(int R,int ITS,int n_states,int n_colors) : R(R),ITS(ITS),SIDE(2*R+1),
+            n_states_(n_states),n_colors_(n_colors),COLOR_BITS(n_colors<=2 ? 1 : n_colors<=4 ? 2 : n_colors<=16 ? 4 : 8),
+            TILE_BITS(tile_bits(COLOR_BITS)),TILE_SIDE(1<<TILE_BITS),TILES_PER_SIDE((SIDE+TILE_SIDE-1)>>TILE_BITS),TILE_MASK(TILE_SIDE-1)
+        {
+            if(TILE_BITS==0 || dense_cells(SIDE,N_DIM)==0)
+                return; // not usable
+            // which tiles lie wholly on the grid (the grids are convex, so the corners are enough)
+            const unsigned int n_tiles = dense_cells(TILES_PER_SIDE,N_DIM);
+            interior.resize(n_tiles);
+            int tile_pos[N_DIM],corner[N_DIM];
+            for(unsigned int iTile=0;iTile<n_tiles;iTile++)
+            {
+                unsigned int rest = iTile;
+                for(int iDim=N_DIM-1;iDim>=0;iDim--)
+                {
+                    tile_pos[iDim] = (rest % TILES_PER_SIDE) << TILE_BITS;
+                    rest /= TILES_PER_SIDE;
+                }
+                bool inside = true;
+                for(int iCorner=0;iCorner<(1<<N_DIM) && inside;iCorner++)
+                {
+                    for(int iDim=0;iDim<N_DIM;iDim++)
+                        corner[iDim] = tile_pos[iDim] + (((iCorner>>iDim)&1) ? TILE_SIDE-1 : 0);
+                    inside = Topology::contains(corner,SIDE);
+                }
+                interior[iTile] = inside;
+            }
+        }
+
+        // false if a tile can't fit in a word (many dimensions and colors) or the grid is too large
+        bool usable() const { return !interior.empty(); }
+
+        int n_states() const { return N_STATES_!=RUNTIME ? N_STATES_ : n_states_; }
+        int n_colors() const { return N_COLORS_!=RUNTIME ? N_COLORS_ : n_colors_; }
+
+        void prepare_grid(Grid &grid) const { grid.resize((unsigned int)interior.size()); }
+
+        // as for TurmiteEngine
+        void start(TurmiteState &t) const
+        {
+            t.pos.assign(N_DIM,R); // start in the middle
+            t.state = 0;
+            t.dir = Movement::START_DIR;
+            t.its = 0;
+            t.n_nonzero = 0;
+            t.max_slot = -1;
+            t.hash = 0;
+            t.cycle.reset();
+        }
+
+        // run a turmite on the given grid until it halts, moves off the grid, repeats a configuration
+        // or has taken ITS steps
+        RunOutcome run(const TransitionTable &transitions,Grid &grid,TurmiteState &t) const
+        {
+            const int SIDE=this->SIDE,ITS=this->ITS,N_COLORS=n_colors();
+            const unsigned long long COLOR_MASK = (1ULL<<COLOR_BITS)-1;
+            int ts=t.state,t_pos[N_DIM],t_dir=t.dir,its=t.its,n_nonzero=t.n_nonzero,max_slot=t.max_slot,iDim,iCell,iSlot,new_dir;
+            int n_looks=0; // the number of transits and single steps, for the cycle detector
+            int worked_out=0,looked_up=0; // the steps of the transits since the last check
+            int next_check=its+CHECK_EVERY,single_until=its,pause=CHECK_EVERY; // (see above)
+            bool found;
+            unsigned int iTile,iLocal,shift;
+            unsigned long long hash=t.hash,contents,new_contents;
+            unsigned char color,new_color,move;
+            TransitionTable::Transition transition;
+            RunOutcome outcome;
+            for(iDim=0;iDim<N_DIM;iDim++) t_pos[iDim] = t.pos[iDim];
+            for(;;)
+            {
+                if(its>=ITS)
+                {
+                    outcome = TIMED_OUT;
+                    break;
+                }
+                if(its>=next_check)
+                {
+                    if(worked_out>looked_up)
+                    {
+                        single_until = its+pause;
+                        pause = pause<ITS/4 ? 4*pause : ITS;
+                    }
+                    else
+                        pause = CHECK_EVERY;
+                    worked_out = looked_up = 0;
+                    next_check = (single_until>its ? single_until : its) + CHECK_EVERY;
+                }
+                iTile = t_pos[0] >> TILE_BITS;
+                iLocal = t_pos[0] & TILE_MASK;
+                iCell = t_pos[0];
+                for(iDim=1;iDim<N_DIM;iDim++)
+                {
+                    iTile = iTile*TILES_PER_SIDE + (t_pos[iDim] >> TILE_BITS);
+                    iLocal = iLocal<<TILE_BITS | (t_pos[iDim] & TILE_MASK);
+                    iCell = iCell*SIDE + t_pos[iDim];
+                }
+                if(t.cycle.repeated(n_looks++,hash,iCell,ts,t_dir,grid))
+                {
+                    outcome = CYCLED;
+                    break;
+                }
+                contents = grid[iTile];
+                if(its>=single_until && interior[iTile])
+                {
+                    const MacroTransit &transit = find_transit(transitions,grid,contents,iLocal,ts,t_dir,found);
+                    (found ? looked_up : worked_out) += transit.steps;
+                    max_slot = transit.max_slot>max_slot ? transit.max_slot : max_slot; // (even if it isn't taken, it changes the course of the run)
+                    if(its+transit.steps<=ITS)
+                    {
+                        if(transit.new_contents!=contents)
+                        {
+                            grid.set(iTile,transit.new_contents);
+                            hash ^= tile_key(iTile,contents) ^ tile_key(iTile,transit.new_contents);
+                        }
+                        n_nonzero += transit.nonzero_change;
+                        its += transit.steps;
+                        if(transit.end==MacroTransit::HALTED)
+                        {
+                            outcome = HALTED;
+                            break;
+                        }
+                        for(iDim=N_DIM-1;iDim>=0;iDim--)
+                            t_pos[iDim] = (t_pos[iDim] & ~TILE_MASK) | ((transit.cell >> (TILE_BITS*(N_DIM-1-iDim))) & TILE_MASK);
+                        ts = transit.state;
+                        if(transit.end==MacroTransit::STAYED)
+                            t_dir = transit.dir;
+                        else
+                        {
+                            if(!Topology::move(t_pos,transit.dir,SIDE))
+                            {
+                                its--; // (as in TurmiteEngine, the step off the grid isn't counted)
+                                outcome = OFF_GRID;
+                                break;
+                            }
+                            if(Movement::RELATIVE)
+                                t_dir = transit.dir;
+                        }
+                        continue;
+                    }
+                }
+                // a single step, as in TurmiteEngine
+                shift = iLocal*COLOR_BITS;
+                color = (unsigned char)((contents >> shift) & COLOR_MASK);
+                iSlot = ts*N_COLORS+color;
+                max_slot = iSlot>max_slot ? iSlot : max_slot;
+                transition = transitions[iSlot+ts];
+                move = TransitionTable::move(transition);
+                new_color = TransitionTable::color(transition);
+                if(color!=new_color)
+                {
+                    new_contents = contents ^ ((unsigned long long)(color^new_color) << shift);
+                    grid.set(iTile,new_contents);
+                    hash ^= tile_key(iTile,contents) ^ tile_key(iTile,new_contents);
+                    if(color==0) n_nonzero++;
+                    else if(new_color==0) n_nonzero--;
+                }
+                its++;
+                if(move==0)
+                {
+                    outcome = HALTED;
+                    break;
+                }
+                new_dir = Movement::template direction<Topology>(t_dir,move);
+                if(!Topology::move(t_pos,new_dir,SIDE))
+                {
+                    its--;
+                    outcome = OFF_GRID;
+                    break;
+                }
+                ts = TransitionTable::state(transition);
+                if(Movement::RELATIVE)
+                    t_dir = new_dir;
+            }
+            for(iDim=0;iDim<N_DIM;iDim++) t.pos[iDim] = t_pos[iDim];
+            t.state = ts;
+            t.dir = t_dir;
+            t.its = its;
+            t.n_nonzero = n_nonzero;
+            t.max_slot = max_slot;
+            t.hash = hash;
+            return outcome;
+        }
+
+    private:
+
+        // Inside a tile the turmite is moved with coordinates offset by LOCAL_OFFSET on a grid of side
+        // LOCAL_SIDE, so that Topology::move never stops it. (LOCAL_OFFSET is even, like the corners of
+        // the tiles, so that tri cells point the same way.)
+        static const int LOCAL_OFFSET = 64;
+        static const int LOCAL_SIDE = 2*LOCAL_OFFSET+1;
+
+        // the largest tiles, with a power of two along each side, whose cells fit in a word
+        static int tile_bits(int color_bits)
+        {
+            int bits=0;
+            while(((bits+1)*N_DIM<=6) && (color_bits<<((bits+1)*N_DIM))<=64)
+                bits++;
+            return bits;
+        }
+
+        // the Zobrist key of a tile (see cycle_detection.h)
+        static unsigned long long tile_key(unsigned int iTile,unsigned long long contents)
+        {
+            unsigned long long z = contents ^ ((unsigned long long)iTile*0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z ^= z >> 31;
+            return contents==0 ? 0 : z;
+        }
+
+        // the transit for a turmite entering a tile, worked out if it isn't in the cache (found is false)
+        const MacroTransit &find_transit(const TransitionTable &transitions,MacroGrid &grid,
+            unsigned long long contents,unsigned int iLocal,int ts,int t_dir,bool &found) const
+        {
+            const int N_COLORS=n_colors();
+            const unsigned long long COLOR_MASK = (1ULL<<COLOR_BITS)-1;
+            MacroTransit &transit = grid.transit(contents,iLocal | ts<<8 | t_dir<<16,found);
+            if(found)
+                return transit;
+            int pos[N_DIM],next_pos[N_DIM],iDim,new_dir;
+            unsigned char color,new_color,move;
+            TransitionTable::Transition transition;
+            for(iDim=N_DIM-1;iDim>=0;iDim--)
+                pos[iDim] = LOCAL_OFFSET + ((iLocal >> (TILE_BITS*(N_DIM-1-iDim))) & TILE_MASK);
+            transit.steps = 0;
+            transit.nonzero_change = 0;
+            transit.max_slot = -1;
+            for(;;)
+            {
+                iLocal = pos[0]-LOCAL_OFFSET;
+                for(iDim=1;iDim<N_DIM;iDim++) iLocal = iLocal<<TILE_BITS | (pos[iDim]-LOCAL_OFFSET);
+                color = (unsigned char)((contents >> (iLocal*COLOR_BITS)) & COLOR_MASK);
+                transition = transitions[ts*N_COLORS+color+ts];
+                if(ts*N_COLORS+color>transit.max_slot)
+                    transit.max_slot = ts*N_COLORS+color;
+                move = TransitionTable::move(transition);
+                new_color = TransitionTable::color(transition);
+                if(color!=new_color)
+                {
+                    contents ^= (unsigned long long)(color^new_color) << (iLocal*COLOR_BITS);
+                    if(color==0) transit.nonzero_change++;
+                    else if(new_color==0) transit.nonzero_change--;
+                }
+                transit.steps++;
+                transit.cell = (unsigned char)iLocal;
+                if(move==0)
+                {
+                    transit.end = MacroTransit::HALTED;
+                    break;
+                }
+                new_dir = Movement::template direction<Topology>(t_dir,move);
+                for(iDim=0;iDim<N_DIM;iDim++) next_pos[iDim] = pos[iDim];
+                Topology::move(next_pos,new_dir,LOCAL_SIDE);
+                bool inside = true;
+                for(iDim=0;iDim<N_DIM;iDim++)
+                    inside = inside && next_pos[iDim]>=LOCAL_OFFSET && next_pos[iDim]<LOCAL_OFFSET+TILE_SIDE;
+                if(!inside)
+                {
+                    transit.end = MacroTransit::LEFT;
+                    transit.state = TransitionTable::state(transition);
+                    transit.dir = (unsigned char)new_dir;
+                    break;
+                }
+                for(iDim=0;iDim<N_DIM;iDim++) pos[iDim] = next_pos[iDim];
+                ts = TransitionTable::state(transition);
+                if(Movement::RELATIVE)
+                    t_dir = new_dir;
+                if(transit.steps==MAX_TRANSIT)
+                {
+                    transit.end = MacroTransit::STAYED;
+                    transit.cell = (unsigned char)(pos[0]-LOCAL_OFFSET);
+                    for(iDim=1;iDim<N_DIM;iDim++) transit.cell = (unsigned char)(transit.cell<<TILE_BITS | (pos[iDim]-LOCAL_OFFSET));
+                    transit.state = (unsigned char)ts;
+                    transit.dir = (unsigned char)t_dir;
+                    break;
+                }
+            }
+            transit.new_contents = contents;
+            return transit;
+        }
+
+        const int R,ITS,SIDE;
+        const int n_states_,n_colors_; // (only used by the generic kernel)
+        const int COLOR_BITS; // the bits of each cell in a tile
+        const int TILE_BITS,TILE_SIDE,TILES_PER_SIDE; // TILE_BITS is 0 if no tile fits in a word
+        const unsigned int TILE_MASK;
+        std::vector<unsigned char> interior; // whether each tile lies wholly on the grid
+};
+
+#endif
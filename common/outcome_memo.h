@@ -0,0 +1,105 @@
+// Remembering the outcomes of the odometer's runs, so that machines that would run the same way are
+// not run again.
+//
+// A run depends only on the transitions it reads. The slots are the digits of the odometer, with
+// slot 0 = (state 0,color 0) the lowest, and slot 0 is always read first, so the slots that a run
+// never reads are usually high ones (those of a state it never enters, say). A run that read only
+// slots 0..max_slot gives the same outcome for every machine with the same digits in those slots,
+// and the odometer comes back to those digits every time a higher digit moves on. So the outcome is
+// kept under the digits of slots 0..max_slot, in a table for each max_slot (as long as the tables
+// fit in max_entries), and looked up before a machine is run.
+
+#ifndef OUTCOME_MEMO_H
+#define OUTCOME_MEMO_H
+
+// STL:
+#include <vector>
+
+// local:
+#include "turmite.h"
+
+class OutcomeMemo
+{
+    public:
+
+        struct Outcome
+        {
+            RunOutcome outcome;
+            int its,n_nonzero;
+        };
+
+        OutcomeMemo(const std::vector<std::vector<unsigned char> > &possible_entries,size_t max_entries)
+            : possible_entries(possible_entries)
+        {
+            size_t n_entries=1,total=0;
+            for(size_t iSlot=0;iSlot<possible_entries.size()/3;iSlot++)
+            {
+                const size_t radix = possible_entries[iSlot*3+0].size()*possible_entries[iSlot*3+1].size()
+                    *possible_entries[iSlot*3+2].size();
+                n_entries *= radix;
+                total += n_entries;
+                if(total>max_entries)
+                    break;
+                known.push_back(std::vector<Entry>(n_entries));
+            }
+        }
+
+        // if the outcome of a machine (indices into possible_entries) is known, puts it in found
+        bool find(const unsigned char *turmite,Outcome &found) const
+        {
+            size_t index=0,weight=1;
+            for(size_t iSlot=0;iSlot<known.size();iSlot++)
+            {
+                index += digit(turmite,iSlot)*weight;
+                weight = known[iSlot].size();
+                const Entry &entry = known[iSlot][index];
+                if(entry.outcome>=0)
+                {
+                    found.outcome = (RunOutcome)entry.outcome;
+                    found.its = entry.its;
+                    found.n_nonzero = entry.n_nonzero;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // the machine ran with the given outcome, reading no slot above max_slot
+        void add(const unsigned char *turmite,int max_slot,RunOutcome outcome,int its,int n_nonzero)
+        {
+            if(max_slot<0 || max_slot>=(int)known.size())
+                return;
+            size_t index=0,weight=1;
+            for(int iSlot=0;iSlot<=max_slot;iSlot++)
+            {
+                index += digit(turmite,iSlot)*weight;
+                weight = known[iSlot].size();
+            }
+            Entry &entry = known[max_slot][index];
+            entry.outcome = (signed char)outcome;
+            entry.its = its;
+            entry.n_nonzero = n_nonzero;
+        }
+
+    private:
+
+        // the slot's value (as in the odometer's slot_allowed)
+        size_t digit(const unsigned char *turmite,size_t iSlot) const
+        {
+            const size_t iEntry = iSlot*3;
+            return turmite[iEntry] + possible_entries[iEntry].size()*(turmite[iEntry+1]
+                + possible_entries[iEntry+1].size()*turmite[iEntry+2]);
+        }
+
+        struct Entry
+        {
+            int its,n_nonzero;
+            signed char outcome; // -1 if not known
+            Entry() : its(0),n_nonzero(0),outcome(-1) {}
+        };
+
+        const std::vector<std::vector<unsigned char> > &possible_entries;
+        std::vector<std::vector<Entry> > known; // known[max_slot][the digits of slots 0..max_slot]
+};
+
+#endif
@@ -0,0 +1,268 @@
+// Keeping the outcomes of a search on disk, so that a later search of the same machines with more
+// steps or a larger radius only runs the ones that the earlier search left undecided.
+//
+// The file starts with a line that says which search wrote it: the grid, movement and numbers of
+// states and colors, a fingerprint of the possible entries (which fix how the machines are
+// numbered) and its ITS and R. Then come the outcomes of the machines it tested, in the order of
+// the odometer, in blocks of up to BLOCK_ENTRIES. A block has a header of the first machine, the
+// number of outcomes and the length of the rest, which holds for each outcome the gap since the
+// machine before, its steps and outcome together and for a halt its population, as variable-length
+// numbers (7 bits a byte): a few bytes an outcome. A reader makes an index of the blocks from their
+// headers and each thread reads the blocks it needs, so the file doesn't have to fit in memory.
+//
+// On a grid at least as large, a run goes step for step as it did before until it stops or leaves
+// the smaller grid. So an outcome is known with new limits if it came within the new ITS, unless
+// the turmite moved off a grid that is now larger, and if it came later (or the turmite was still
+// running) it is now still running at the new ITS. Everything else is run again.
+
+#ifndef OUTCOME_STORE_H
+#define OUTCOME_STORE_H
+
+// stdlib:
+#include <stdio.h>
+
+// STL:
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// local:
+#include "turmite.h"
+
+struct StoredOutcome
+{
+    unsigned long long machine; // its index in the odometer
+    RunOutcome outcome; // HALTED, OFF_GRID, CYCLED or TIMED_OUT
+    int its,n_nonzero; // (n_nonzero is only kept for HALTED)
+};
+
+// the first line of a file of outcomes: search names the grid, movement, states and colors
+inline std::string outcome_store_header(const std::string &search,
+    const std::vector<std::vector<unsigned char> > &possible_entries,int ITS,int R)
+{
+    unsigned long long fingerprint = 14695981039346656037ULL; // (FNV-1a)
+    for(size_t iEntry=0;iEntry<possible_entries.size();iEntry++)
+    {
+        fingerprint = (fingerprint ^ possible_entries[iEntry].size()) * 1099511628211ULL;
+        for(size_t i=0;i<possible_entries[iEntry].size();i++)
+            fingerprint = (fingerprint ^ possible_entries[iEntry][i]) * 1099511628211ULL;
+    }
+    std::ostringstream header;
+    header << "turmite outcomes: " << search << " entries=" << std::hex << fingerprint << std::dec << " ITS=" << ITS << " R=" << R << "\n";
+    return header.str();
+}
+
+class OutcomeStore
+{
+    public:
+
+        static const size_t BLOCK_ENTRIES = 4096;
+        static const size_t BLOCK_HEADER = 16; // the first machine (8 bytes), the number of outcomes and the length of the rest (4 each)
+
+        // adds the outcomes (in order) to bytes, as blocks
+        static void encode(const std::vector<StoredOutcome> &outcomes,std::string &bytes)
+        {
+            std::string block;
+            for(size_t iFirst=0;iFirst<outcomes.size();iFirst+=BLOCK_ENTRIES)
+            {
+                const size_t n = std::min(BLOCK_ENTRIES,outcomes.size()-iFirst);
+                block.clear();
+                for(size_t i=iFirst;i<iFirst+n;i++)
+                {
+                    const StoredOutcome &entry = outcomes[i];
+                    put_number(block,i>iFirst ? entry.machine-outcomes[i-1].machine : 0);
+                    put_number(block,(unsigned long long)entry.its<<2 | entry.outcome);
+                    if(entry.outcome==HALTED)
+                        put_number(block,entry.n_nonzero);
+                }
+                put_fixed(bytes,outcomes[iFirst].machine,8);
+                put_fixed(bytes,n,4);
+                put_fixed(bytes,block.size(),4);
+                bytes += block;
+            }
+        }
+
+        // reads the header line and the headers of the blocks, returns false if the file can't be read
+        bool open(const std::string &filename)
+        {
+            this->filename = filename;
+            std::ifstream in(filename.c_str(),std::ios::binary);
+            if(!std::getline(in,header))
+                return false;
+            header += "\n";
+            const size_t found_ITS = header.rfind(" ITS="), found_R = header.rfind(" R=");
+            if(found_ITS==std::string::npos || found_R==std::string::npos
+                || sscanf(header.c_str()+found_ITS," ITS=%d R=%d",&ITS,&R)!=2)
+                return false;
+            unsigned char bytes[BLOCK_HEADER];
+            blocks.clear();
+            for(unsigned long long offset=header.size();;)
+            {
+                in.read((char*)bytes,BLOCK_HEADER);
+                if(in.gcount()==0 && in.eof())
+                    return true;
+                if(in.gcount()!=(std::streamsize)BLOCK_HEADER)
+                    return false;
+                Block block;
+                block.first = get_fixed(bytes,8);
+                block.offset = offset+BLOCK_HEADER;
+                block.n = (size_t)get_fixed(bytes+8,4);
+                block.length = (size_t)get_fixed(bytes+12,4);
+                if(!blocks.empty() && block.first<=blocks.back().first)
+                    return false; // (not in order)
+                blocks.push_back(block);
+                offset = block.offset+block.length;
+                in.seekg(offset);
+            }
+        }
+
+        // the header line, without the limits
+        std::string search() const { return header.substr(0,header.rfind(" ITS=")); }
+        int its() const { return ITS; }
+        int radius() const { return R; }
+
+        // what the stored outcome becomes with a step limit of new_ITS on a grid of radius new_R,
+        // returns false if it can't be known without running the machine again
+        bool carry_over(const StoredOutcome &stored,int new_ITS,int new_R,StoredOutcome &now) const
+        {
+            if(new_R<R)
+                return false; // (the turmite might have gone further than new_R)
+            // the step in which the run stopped, counting from 0 (for a turmite still running, its last)
+            const int stopped = stored.outcome==HALTED ? stored.its-1 : stored.outcome==TIMED_OUT ? ITS : stored.its;
+            now = stored;
+            if(stopped>=new_ITS)
+            {
+                now.outcome = TIMED_OUT;
+                now.its = new_ITS;
+                now.n_nonzero = 0;
+                return true;
+            }
+            return stored.outcome==HALTED || stored.outcome==CYCLED || (stored.outcome==OFF_GRID && new_R==R);
+        }
+
+        // looks up machines in increasing order (one for each thread)
+        class Cursor
+        {
+            public:
+
+                explicit Cursor(const OutcomeStore &store) : store(store),in(store.filename.c_str(),std::ios::binary),iBlock(-1),iNext(0) {}
+
+                // returns false if the machine isn't in the store
+                bool find(unsigned long long machine,StoredOutcome &stored)
+                {
+                    const std::vector<Block> &blocks = store.blocks;
+                    if(iBlock<0 || machine<blocks[iBlock].first || (iBlock+1<(int)blocks.size() && machine>=blocks[iBlock+1].first))
+                    {
+                        // the last block that starts at or before the machine
+                        int iFound = (int)(std::upper_bound(blocks.begin(),blocks.end(),machine,
+                            [](unsigned long long m,const Block &block) { return m<block.first; }) - blocks.begin()) - 1;
+                        if(iFound<0)
+                            return false;
+                        if(!read_block(iFound))
+                            return false;
+                    }
+                    if(iNext>0 && outcomes[iNext-1].machine>=machine)
+                        iNext = 0; // (not in increasing order after all)
+                    while(iNext<outcomes.size() && outcomes[iNext].machine<machine)
+                        iNext++;
+                    if(iNext==outcomes.size() || outcomes[iNext].machine!=machine)
+                        return false;
+                    stored = outcomes[iNext++];
+                    return true;
+                }
+
+            private:
+
+                bool read_block(int iFound)
+                {
+                    const Block &block = store.blocks[iFound];
+                    iBlock = -1;
+                    outcomes.clear();
+                    iNext = 0;
+                    bytes.resize(block.length);
+                    in.clear();
+                    in.seekg(block.offset);
+                    if(block.length>0)
+                        in.read(&bytes[0],block.length);
+                    if(!in)
+                        return false;
+                    size_t pos=0;
+                    unsigned long long machine = block.first;
+                    for(size_t i=0;i<block.n;i++)
+                    {
+                        StoredOutcome entry;
+                        machine += get_number(bytes,pos);
+                        const unsigned long long its_outcome = get_number(bytes,pos);
+                        entry.machine = machine;
+                        entry.outcome = (RunOutcome)(its_outcome&3);
+                        entry.its = (int)(its_outcome>>2);
+                        entry.n_nonzero = entry.outcome==HALTED ? (int)get_number(bytes,pos) : 0;
+                        outcomes.push_back(entry);
+                    }
+                    iBlock = iFound;
+                    return true;
+                }
+
+                const OutcomeStore &store;
+                std::ifstream in;
+                int iBlock; // the block in outcomes, or -1
+                std::vector<StoredOutcome> outcomes;
+                size_t iNext; // the first of outcomes not looked at yet
+                std::string bytes;
+        };
+
+    private:
+
+        struct Block
+        {
+            unsigned long long first; // the first machine
+            unsigned long long offset; // where the outcomes start in the file
+            size_t n,length; // the number of outcomes and their length in bytes
+        };
+
+        static void put_fixed(std::string &bytes,unsigned long long value,int n_bytes)
+        {
+            for(int i=0;i<n_bytes;i++)
+                bytes += (char)((value>>(8*i))&0xff);
+        }
+
+        static unsigned long long get_fixed(const unsigned char *bytes,int n_bytes)
+        {
+            unsigned long long value=0;
+            for(int i=n_bytes-1;i>=0;i--)
+                value = value<<8 | bytes[i];
+            return value;
+        }
+
+        static void put_number(std::string &bytes,unsigned long long value)
+        {
+            while(value>=0x80)
+            {
+                bytes += (char)(0x80 | (value&0x7f));
+                value >>= 7;
+            }
+            bytes += (char)value;
+        }
+
+        // (a damaged block reads as zeros rather than past its end)
+        static unsigned long long get_number(const std::string &bytes,size_t &pos)
+        {
+            unsigned long long value=0;
+            for(int shift=0;pos<bytes.size() && shift<64;shift+=7)
+            {
+                const unsigned char byte = (unsigned char)bytes[pos++];
+                value |= (unsigned long long)(byte&0x7f)<<shift;
+                if(!(byte&0x80))
+                    break;
+            }
+            return value;
+        }
+
+        std::string filename,header;
+        int ITS,R;
+        std::vector<Block> blocks;
+};
+
+#endif
@@ -0,0 +1,286 @@
+// Parallel enumeration of the turmite odometer.
+//
+// The machines are numbered by their mixed-radix index, with turmite[0] as the least significant
+// digit (the order in which the odometer increments). The index range is split into chunks that
+// share the same high-order digits, and the chunks are handed out to a work-stealing pool of
+// threads. Each chunk keeps its own records; these are replayed in chunk order on the calling
+// thread so that the record log is the same as for a single-threaded run.
+
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+// STL:
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// local:
+#include "outcome_store.h"
+#include "search_stats.h"
+#include "turmite.h"
+
+// a halting machine that beat the records so far in its chunk (or for the log, any halting machine)
+struct FoundRecord
+{
+    int its;
+    int n_nonzero;
+    std::vector<unsigned char> turmite; // turmite[i] is an index into possible_entries[i]
+    std::vector<int> bounds; // for the log: the lowest then the highest coordinate of its cells along each axis
+    std::vector<unsigned char> cells; // with pictures: the colors inside bounds, the last axis changing fastest
+};
+
+// with --stages, a machine that moved off the grid or was still running, to be run again with the
+// next stage's budget
+struct HeldOut
+{
+    unsigned long long machine; // its index
+    RunOutcome outcome; // OFF_GRID or TIMED_OUT
+};
+
+struct ChunkResult
+{
+    unsigned long long tried,tested;
+    unsigned long long n_unreachable; // passed the other filters but can never halt, so weren't tested (see reachability.h)
+    unsigned long long n_off_grid,n_cycled,n_timed_out; // why the tested machines that didn't halt were rejected
+    std::vector<FoundRecord> records; // in enumeration order
+    std::vector<FoundRecord> halted; // for the log of halting machines, in enumeration order
+    std::vector<HeldOut> held_out; // with --stages, in enumeration order
+    std::vector<StoredOutcome> outcomes; // with --save-outcomes, of the tested machines in enumeration order
+    SearchStats stats;
+
+    ChunkResult() : tried(0),tested(0),n_unreachable(0),n_off_grid(0),n_cycled(0),n_timed_out(0) {}
+
+    void count_rejected(RunOutcome outcome,unsigned long long n)
+    {
+        if(outcome==OFF_GRID) n_off_grid += n;
+        else if(outcome==CYCLED) n_cycled += n;
+        else if(outcome==TIMED_OUT) n_timed_out += n;
+    }
+};
+
+// set turmite[] to the digits of the machine with the given index
+inline void index_to_turmite(unsigned long long index,
+    const std::vector<std::vector<unsigned char> >& possible_entries,unsigned char *turmite)
+{
+    for(size_t iEntry=0;iEntry<possible_entries.size();iEntry++)
+    {
+        turmite[iEntry] = (unsigned char)(index % possible_entries[iEntry].size());
+        index /= possible_entries[iEntry].size();
+    }
+}
+
+inline unsigned long long turmite_to_index(const unsigned char *turmite,
+    const std::vector<std::vector<unsigned char> >& possible_entries)
+{
+    unsigned long long index=0;
+    for(size_t iEntry=possible_entries.size();iEntry-->0;)
+        index = index*possible_entries[iEntry].size() + turmite[iEntry];
+    return index;
+}
+
+// Sets [first,last) to the part of [0,n) covered by the given shard (counting from 1) of n_shards.
+// Every shard gets the same number of items, give or take one.
+inline void shard_slice(unsigned long long n,int shard,int n_shards,unsigned long long &first,unsigned long long &last)
+{
+    // n*k/n_shards, without overflow
+    const unsigned long long q = n/n_shards, r = n%n_shards;
+    first = q*(shard-1) + r*(shard-1)/n_shards;
+    last = q*shard + r*shard/n_shards;
+}
+
+// A chunk is the set of machines that share the values of the top few digits.
+struct ChunkLayout
+{
+    unsigned long long n_chunks;
+    unsigned long long stride; // number of machines in each chunk
+};
+
+inline ChunkLayout make_chunk_layout(const std::vector<std::vector<unsigned char> >& possible_entries,int n_threads)
+{
+    // small chunks keep the threads busy at the end of the run and the progress reports regular
+    const unsigned long long MAX_CHUNK_SIZE=1<<20;
+    const unsigned long long MIN_CHUNKS_PER_THREAD=16;
+    ChunkLayout layout;
+    layout.n_chunks=1;
+    layout.stride=1;
+    for(size_t iEntry=0;iEntry<possible_entries.size();iEntry++)
+        layout.stride *= possible_entries[iEntry].size();
+    for(size_t iEntry=possible_entries.size();iEntry-->0;)
+    {
+        if(layout.stride<=MAX_CHUNK_SIZE && layout.n_chunks>=MIN_CHUNKS_PER_THREAD*n_threads)
+            break;
+        layout.n_chunks *= possible_entries[iEntry].size();
+        layout.stride /= possible_entries[iEntry].size();
+    }
+    return layout;
+}
+
+// Runs search(thread,chunk,result) for every chunk in [first_chunk,last_chunk) on n_threads worker
+// threads, and commit(chunk,result) on the calling thread, strictly in chunk order. If stop() returns
+// true the workers finish the chunks they are on and the run ends early. Returns the first chunk that
+// wasn't committed (last_chunk if the run wasn't stopped).
+//
+// Each worker owns a queue of chunks { first + k*n_threads }, which keeps the workers close together
+// so that finished chunks can be committed promptly. A worker with an empty queue steals the back
+// half of the queue of another worker. A finished chunk waits until the ones before it have been
+// committed, so to keep one slow chunk from letting the results pile up without limit, a worker
+// doesn't start a chunk more than LOOK_AHEAD*n_threads past the first that hasn't been committed.
+// (The chunk that holds things up is then being searched, or is in the queue of a worker that
+// isn't waiting: a worker's chunk comes before the rest of its queue.)
+class ChunkPool
+{
+    public:
+
+        typedef std::function<void(int,unsigned long long,ChunkResult&)> SearchFunction;
+        typedef std::function<void(unsigned long long,ChunkResult&)> CommitFunction;
+        typedef std::function<bool()> StopFunction;
+
+        static const unsigned long long LOOK_AHEAD = 4;
+
+        static unsigned long long run(int n_threads,unsigned long long first_chunk,unsigned long long last_chunk,
+            SearchFunction search,CommitFunction commit,StopFunction stop=StopFunction())
+        {
+            ChunkPool pool(n_threads,first_chunk,last_chunk);
+            std::vector<std::thread> workers;
+            for(int iThread=0;iThread<n_threads;iThread++)
+                workers.push_back(std::thread(&ChunkPool::work,&pool,iThread,search));
+            unsigned long long chunk;
+            for(chunk=first_chunk;chunk<last_chunk;chunk++)
+            {
+                ChunkResult result;
+                {
+                    std::unique_lock<std::mutex> lock(pool.results_mutex);
+                    while(pool.results.find(chunk)==pool.results.end() && !pool.stopping)
+                    {
+                        // wake up now and then to check whether we've been asked to stop
+                        pool.result_ready.wait_for(lock,std::chrono::milliseconds(100));
+                        if(stop && stop())
+                            pool.stopping = true;
+                    }
+                    if(pool.stopping)
+                        break;
+                    std::swap(result,pool.results[chunk]);
+                    pool.results.erase(chunk);
+                    pool.next_to_commit = chunk+1;
+                    pool.committed.notify_all();
+                }
+                commit(chunk,result);
+                if(stop && stop())
+                {
+                    pool.stopping = true;
+                    chunk++;
+                    break;
+                }
+            }
+            {
+                // (wakes any workers that are waiting to get further ahead, if we stopped early)
+                std::lock_guard<std::mutex> lock(pool.results_mutex);
+                pool.stopping = true;
+                pool.committed.notify_all();
+            }
+            for(int iThread=0;iThread<n_threads;iThread++)
+                workers[iThread].join();
+            return chunk;
+        }
+
+    private:
+
+        // the chunks { first + k*stride : 0 <= k < count }
+        struct Queue
+        {
+            std::mutex mutex;
+            unsigned long long first,count;
+        };
+
+        ChunkPool(int n_threads,unsigned long long first_chunk,unsigned long long last_chunk)
+            : queues(n_threads),stopping(false),next_to_commit(first_chunk)
+        {
+            stride = n_threads;
+            max_ahead = LOOK_AHEAD*n_threads;
+            for(int iThread=0;iThread<n_threads;iThread++)
+            {
+                queues[iThread].first = first_chunk+iThread;
+                if(queues[iThread].first<last_chunk)
+                    queues[iThread].count = (last_chunk-queues[iThread].first+stride-1)/stride;
+                else
+                    queues[iThread].count = 0;
+            }
+        }
+
+        bool pop_front(int iThread,unsigned long long &chunk)
+        {
+            Queue &q = queues[iThread];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if(q.count==0)
+                return false;
+            chunk = q.first;
+            q.first += stride;
+            q.count--;
+            return true;
+        }
+
+        bool steal(int iThread)
+        {
+            for(size_t i=1;i<queues.size();i++)
+            {
+                Queue &victim = queues[(iThread+i)%queues.size()];
+                unsigned long long first,count;
+                {
+                    std::lock_guard<std::mutex> lock(victim.mutex);
+                    if(victim.count==0)
+                        continue;
+                    count = (victim.count+1)/2;
+                    victim.count -= count;
+                    first = victim.first + victim.count*stride;
+                }
+                Queue &q = queues[iThread];
+                std::lock_guard<std::mutex> lock(q.mutex);
+                q.first = first;
+                q.count = count;
+                return true;
+            }
+            return false;
+        }
+
+        void work(int iThread,SearchFunction search)
+        {
+            unsigned long long chunk;
+            while(!stopping)
+            {
+                if(!pop_front(iThread,chunk))
+                {
+                    if(!steal(iThread))
+                        return; // every queue is empty
+                    continue;
+                }
+                {
+                    std::unique_lock<std::mutex> lock(results_mutex);
+                    while(chunk>=next_to_commit+max_ahead && !stopping)
+                        committed.wait(lock);
+                }
+                if(stopping)
+                    return;
+                ChunkResult result;
+                search(iThread,chunk,result);
+                std::lock_guard<std::mutex> lock(results_mutex);
+                std::swap(results[chunk],result);
+                result_ready.notify_one();
+            }
+        }
+
+        std::vector<Queue> queues;
+        unsigned long long stride,max_ahead;
+        std::atomic<bool> stopping; // the workers should take no more chunks
+
+        std::mutex results_mutex;
+        std::condition_variable result_ready,committed;
+        std::map<unsigned long long,ChunkResult> results; // finished chunks waiting to be committed
+        unsigned long long next_to_commit; // the first chunk that hasn't been taken for commit()
+};
+
+#endif
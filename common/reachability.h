@@ -0,0 +1,78 @@
+// Ruling out turmites that can never halt, without running them.
+//
+// A turmite starts in state 0 on cells of color 0, so the only transitions it can ever use are
+// those of the states that it can get into from state 0, reading the colors that it can write (or
+// 0). These are found by following the table out from {0,0} until no new state or color turns up,
+// and if the halt isn't among them the turmite can only move off the grid, repeat a configuration
+// or run out of steps: it can't set a record, so the odometer doesn't run it. (A state and a color
+// that both turn up may never meet on the grid, so some turmites that can't halt still get through.)
+//
+// Renumbering the states and colors, or changing the moves by a symmetry, changes nothing here, so
+// a family of symmetric copies (see symmetry.h) is ruled out whole or not at all.
+
+#ifndef REACHABILITY_H
+#define REACHABILITY_H
+
+// STL:
+#include <algorithm>
+#include <vector>
+
+class ReachabilityFilter
+{
+    public:
+
+        ReachabilityFilter(const std::vector<std::vector<unsigned char> > &possible_entries,int n_states,int n_colors)
+            : possible_entries(possible_entries),n_colors(n_colors),state_seen(n_states),color_seen(n_colors),
+            states(n_states),colors(n_colors),slots(n_states*n_colors) {}
+
+        // whether the halting transition of the machine (indices into possible_entries) can be reached
+        bool can_halt(const unsigned char *turmite)
+        {
+            std::fill(state_seen.begin(),state_seen.end(),0);
+            std::fill(color_seen.begin(),color_seen.end(),0);
+            n_states_seen = n_colors_seen = n_slots = 0;
+            see_state(0);
+            see_color(0);
+            for(int iNext=0;iNext<n_slots;iNext++)
+            {
+                const int iEntry = slots[iNext]*3;
+                if(possible_entries[iEntry+1][turmite[iEntry+1]]==0)
+                    return true; // the halt
+                see_color(possible_entries[iEntry+0][turmite[iEntry+0]]);
+                see_state(possible_entries[iEntry+2][turmite[iEntry+2]]);
+            }
+            return false;
+        }
+
+    private:
+
+        // slots[] holds the slots to follow: each pair of a state and a color that have turned up is
+        // added once, when the second of them does
+        void see_state(int state)
+        {
+            if(state_seen[state])
+                return;
+            state_seen[state] = 1;
+            states[n_states_seen++] = state;
+            for(int iColor=0;iColor<n_colors_seen;iColor++)
+                slots[n_slots++] = state*n_colors + colors[iColor];
+        }
+
+        void see_color(int color)
+        {
+            if(color_seen[color])
+                return;
+            color_seen[color] = 1;
+            colors[n_colors_seen++] = color;
+            for(int iState=0;iState<n_states_seen;iState++)
+                slots[n_slots++] = states[iState]*n_colors + color;
+        }
+
+        const std::vector<std::vector<unsigned char> > &possible_entries;
+        const int n_colors;
+        std::vector<unsigned char> state_seen,color_seen;
+        std::vector<int> states,colors,slots; // the states and colors that have turned up, in order, and the slots to follow
+        int n_states_seen,n_colors_seen,n_slots;
+};
+
+#endif
@@ -0,0 +1,228 @@
+// Pictures of the records.
+//
+// When a record is found the cells inside the bounding box of those that aren't color 0 are copied
+// into a GridSnapshot, and a RenderQueue draws it on a thread of its own, so that the search never
+// waits for a picture. The front ends draw their cells as polygons on a GrayImage, which is saved
+// as a PNG without any image library: the pixels are stored in the file uncompressed (a PNG's
+// deflate stream can hold stored blocks), which any viewer reads.
+
+#ifndef RECORD_IMAGES_H
+#define RECORD_IMAGES_H
+
+// stdlib:
+#include <math.h>
+
+// STL:
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the cells of a grid inside the bounding box of those that aren't color 0
+struct GridSnapshot
+{
+    int its,n_nonzero; // of the record
+    std::vector<int> lo,hi; // the lowest and highest coordinate along each axis, relative to the start
+    std::vector<unsigned char> colors; // the cells of the box, the last axis changing fastest
+
+    int size(int iDim) const { return hi[iDim]-lo[iDim]+1; }
+
+    // the color of the cell at pos (relative to the start, inside the box)
+    unsigned char color(const int *pos) const
+    {
+        size_t iCell=0;
+        for(size_t iDim=0;iDim<lo.size();iDim++)
+            iCell = iCell*size((int)iDim) + pos[iDim]-lo[iDim];
+        return colors[iCell];
+    }
+};
+
+// Runs draw(snapshot) for each snapshot added, in order, on a thread of its own. The destructor
+// waits for the pictures still queued.
+class RenderQueue
+{
+    public:
+
+        typedef std::function<void(const GridSnapshot&)> DrawFunction;
+
+        explicit RenderQueue(DrawFunction draw) : draw(draw),done(false)
+        {
+            if(draw)
+                thread = std::thread(&RenderQueue::work,this);
+        }
+
+        ~RenderQueue()
+        {
+            if(!thread.joinable())
+                return;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done = true;
+                wake.notify_one();
+            }
+            thread.join();
+        }
+
+        // queues the snapshot for drawing (taking its contents)
+        void add(GridSnapshot &snapshot)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queued.push_back(GridSnapshot());
+            std::swap(queued.back(),snapshot);
+            wake.notify_one();
+        }
+
+    private:
+
+        void work()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            for(;;)
+            {
+                while(queued.empty() && !done)
+                    wake.wait(lock);
+                if(queued.empty())
+                    return;
+                GridSnapshot snapshot;
+                std::swap(snapshot,queued.front());
+                queued.pop_front();
+                lock.unlock();
+                draw(snapshot);
+                lock.lock();
+            }
+        }
+
+        DrawFunction draw;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<GridSnapshot> queued;
+        bool done;
+};
+
+// an 8-bit grayscale picture
+class GrayImage
+{
+    public:
+
+        GrayImage(int width,int height,unsigned char background)
+            : width(width),height(height),pixels((size_t)width*height,background) {}
+
+        // fills the convex polygon with corners (x[i],y[i]), in pixels: a pixel is filled if its
+        // middle is inside
+        void fill_polygon(const double *x,const double *y,int n,unsigned char gray)
+        {
+            const double y_min = *std::min_element(y,y+n), y_max = *std::max_element(y,y+n);
+            for(int row=std::max(0,(int)floor(y_min));row<std::min(height,(int)ceil(y_max)+1);row++)
+            {
+                // where the edges cross the middle of the row
+                const double yc = row+0.5;
+                double left=1e30,right=-1e30;
+                for(int i=0;i<n;i++)
+                {
+                    const int j = (i+1)%n;
+                    if((y[i]<=yc)==(y[j]<=yc))
+                        continue;
+                    const double xc = x[i] + (yc-y[i])*(x[j]-x[i])/(y[j]-y[i]);
+                    left = std::min(left,xc);
+                    right = std::max(right,xc);
+                }
+                for(int col=std::max(0,(int)ceil(left-0.5));col<std::min(width,(int)ceil(right-0.5));col++)
+                    pixels[(size_t)row*width+col] = gray;
+            }
+        }
+
+        // returns false if the file couldn't be written
+        bool save_png(const std::string &filename) const
+        {
+            // the scanlines, each after a filter byte of 0 (none), in deflate's stored blocks
+            std::vector<unsigned char> raw;
+            raw.reserve((size_t)(width+1)*height);
+            for(int row=0;row<height;row++)
+            {
+                raw.push_back(0);
+                raw.insert(raw.end(),pixels.begin()+(size_t)row*width,pixels.begin()+(size_t)(row+1)*width);
+            }
+            std::vector<unsigned char> zlib;
+            zlib.push_back(0x78); // deflate, 32K window
+            zlib.push_back(0x01); // (check bits)
+            size_t done_bytes=0;
+            do
+            {
+                const size_t n = std::min(raw.size()-done_bytes,(size_t)0xffff);
+                zlib.push_back(done_bytes+n==raw.size() ? 1 : 0); // the last block?
+                zlib.push_back((unsigned char)(n&0xff));
+                zlib.push_back((unsigned char)(n>>8));
+                zlib.push_back((unsigned char)(~n&0xff));
+                zlib.push_back((unsigned char)((~n>>8)&0xff));
+                zlib.insert(zlib.end(),raw.begin()+done_bytes,raw.begin()+done_bytes+n);
+                done_bytes += n;
+            } while(done_bytes<raw.size());
+            put_u32(zlib,adler32(raw));
+
+            std::vector<unsigned char> header;
+            put_u32(header,width);
+            put_u32(header,height);
+            const unsigned char rest[5] = {8,0,0,0,0}; // 8 bits, grayscale, deflate, no filtering choices, not interlaced
+            header.insert(header.end(),rest,rest+5);
+
+            std::ofstream out(filename.c_str(),std::ios::binary);
+            static const unsigned char SIGNATURE[8] = {137,'P','N','G','\r','\n',26,'\n'};
+            out.write((const char*)SIGNATURE,8);
+            write_chunk(out,"IHDR",header);
+            write_chunk(out,"IDAT",zlib);
+            write_chunk(out,"IEND",std::vector<unsigned char>());
+            return !out.fail();
+        }
+
+    private:
+
+        static void put_u32(std::vector<unsigned char> &bytes,unsigned long value)
+        {
+            for(int shift=24;shift>=0;shift-=8)
+                bytes.push_back((unsigned char)((value>>shift)&0xff));
+        }
+
+        static unsigned long adler32(const std::vector<unsigned char> &bytes)
+        {
+            unsigned long a=1,b=0;
+            for(size_t i=0;i<bytes.size();i++)
+            {
+                a = (a+bytes[i])%65521;
+                b = (b+a)%65521;
+            }
+            return b<<16 | a;
+        }
+
+        static unsigned long crc32(const unsigned char *bytes,size_t n,unsigned long crc)
+        {
+            for(size_t i=0;i<n;i++)
+            {
+                crc ^= bytes[i];
+                for(int bit=0;bit<8;bit++)
+                    crc = (crc>>1) ^ (0xEDB88320UL & (0-(crc&1)));
+            }
+            return crc;
+        }
+
+        // a chunk: its length, type, data and the CRC of the type and data
+        static void write_chunk(std::ofstream &out,const char *type,const std::vector<unsigned char> &data)
+        {
+            std::vector<unsigned char> bytes;
+            put_u32(bytes,(unsigned long)data.size());
+            bytes.insert(bytes.end(),type,type+4);
+            bytes.insert(bytes.end(),data.begin(),data.end());
+            put_u32(bytes,crc32(&bytes[4],bytes.size()-4,0xffffffffUL) ^ 0xffffffffUL);
+            out.write((const char*)&bytes[0],bytes.size());
+        }
+
+        int width,height;
+        std::vector<unsigned char> pixels; // row by row, from the top left
+};
+
+#endif
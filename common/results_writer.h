@@ -0,0 +1,114 @@
+// Writing a results file on a thread of its own.
+//
+// The text is made on the thread that commits the chunks (see parallel_search.h) and handed over
+// to a writer thread, so that neither the search nor the commits wait for the disk. Whatever has
+// been handed over when the writer wakes is written in one go. flush() waits until the file has
+// caught up, which a checkpoint needs so that the length it saves covers everything committed.
+
+#ifndef RESULTS_WRITER_H
+#define RESULTS_WRITER_H
+
+// STL:
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class ResultsWriter
+{
+    public:
+
+        ResultsWriter() : writing(false),done(false),length(0) {}
+        ~ResultsWriter() { close(); }
+
+        // opens the file, emptying it unless append is true, and starts the writer thread
+        bool open(const std::string &filename,bool append,bool binary=false)
+        {
+            const std::ios::openmode mode = binary ? std::ios::binary : std::ios::openmode();
+            if(append)
+            {
+                out.open(filename.c_str(),std::ios::in|std::ios::out|mode);
+                out.seekp(0,std::ios::end);
+            }
+            else
+                out.open(filename.c_str(),std::ios::out|mode);
+            if(!out)
+                return false;
+            length = (unsigned long long)out.tellp();
+            done = false;
+            thread = std::thread(&ResultsWriter::work,this);
+            return true;
+        }
+
+        // adds text to the end of the file (doesn't wait for it to be written)
+        void write(const std::string &text)
+        {
+            if(text.empty())
+                return;
+            std::lock_guard<std::mutex> lock(mutex);
+            queued += text;
+            wake.notify_one();
+        }
+
+        // waits until everything passed to write() so far is in the file
+        void flush()
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            while(!queued.empty() || writing)
+                idle.wait(lock);
+        }
+
+        // the length of the file, as of the last flush()
+        unsigned long long size() const { return length; }
+
+        // writes what is left and stops the writer thread
+        void close()
+        {
+            if(!thread.joinable())
+                return;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done = true;
+                wake.notify_one();
+            }
+            thread.join();
+            out.close();
+        }
+
+    private:
+
+        void work()
+        {
+            std::string text;
+            std::unique_lock<std::mutex> lock(mutex);
+            for(;;)
+            {
+                while(queued.empty() && !done)
+                    wake.wait(lock);
+                if(queued.empty())
+                    return; // done, and nothing left to write
+                text.swap(queued);
+                writing = true;
+                lock.unlock();
+                out << text;
+                out.flush();
+                text.clear();
+                lock.lock();
+                length = (unsigned long long)out.tellp();
+                writing = false;
+                idle.notify_all();
+            }
+        }
+
+        std::ofstream out; // only used by the writer thread once it has started
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake,idle;
+        std::string queued; // handed over by write(), not yet written
+        bool writing; // the writer thread is writing text that it took from queued
+        bool done; // close() has been called
+        unsigned long long length;
+};
+
+#endif
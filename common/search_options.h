@@ -0,0 +1,247 @@
+// Command-line options shared by the searchers.
+
+#ifndef SEARCH_OPTIONS_H
+#define SEARCH_OPTIONS_H
+
+// stdlib:
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// STL:
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// the steps and radius that a turmite is given before it is rejected
+struct SearchBudget
+{
+    int ITS,R;
+};
+
+struct SearchOptions
+{
+    int n_threads;
+    bool tree; // enumerate the transitions lazily, as the simulation reaches them
+    bool batch; // run the odometer's turmites several at a time, in lockstep (see batch_engine.h)
+    bool symmetry; // the odometer skips copies of earlier machines up to symmetry (see symmetry.h)
+    bool macro; // the odometer runs long-lived turmites again with macro-steps (see macro_engine.h)
+    bool memo; // the odometer reuses the outcomes of machines that run the same way (see outcome_memo.h)
+    bool prune; // the odometer skips machines that can never reach their halt (see reachability.h)
+    bool translation; // stop turmites that repeat a configuration shifted along (see translation_detection.h)
+    bool resume; // continue from the checkpoint of an earlier run
+    bool stats; // save where the search's time goes, now and then (see search_stats.h)
+    int log_halted; // the odometer logs every machine that halts after at least this many steps (-1 for none)
+    bool save_outcomes; // the odometer saves the outcome of every machine it tests (see outcome_store.h)
+    std::string reuse; // the odometer takes the outcomes that are known with this search's limits from this file
+    int shard,n_shards; // search only part shard (counting from 1) of n_shards
+
+    // the type of turmite to search for (each searcher sets its own defaults before parsing)
+    int n_dims; // 1D, 2D, 3D, etc. (square grids only)
+    int n_states;
+    int n_colors;
+    bool relative; // true: relative Turmites ("TurNing machines"), false: absolute Turmites (Turing machines)
+
+    // constraints we need to help us search
+    int ITS; // Limitation of this approach: if BB lasts longer than this we'll miss it
+    int R; // square radius. Limitation: if BB spreads more than this in any direction we'll miss it
+    bool unbounded; // grow the grid as the turmite moves, instead of stopping at R (see journal_grid.h)
+    int memory_mb; // with unbounded: the most grid memory a turmite can reach, in MB (0 for no limit)
+    std::vector<SearchBudget> stages; // cheaper budgets to run every machine with first, before ITS and R (odometer)
+
+    SearchOptions() : n_threads(std::thread::hardware_concurrency()),tree(false),batch(false),symmetry(true),macro(true),memo(true),prune(true),translation(true),resume(false),stats(false),log_halted(-1),save_outcomes(false),shard(1),n_shards(1),
+        n_dims(2),n_states(2),n_colors(2),relative(false),ITS(10000),R(20),unbounded(false),memory_mb(0)
+    {
+        if(n_threads<1)
+            n_threads = 1;
+    }
+};
+
+inline void print_usage(const char *program,const SearchOptions &defaults)
+{
+    std::cout << "Usage: " << program << " [options]\n"
+        << "  -t, --threads N   number of worker threads (default: one per core)\n"
+        << "  --tree            tree search: only branch on the transitions a turmite actually uses\n"
+        << "  --batch           run the turmites 8 or 16 at a time, in lockstep (odometer only: faster when built\n"
+        << "                    for AVX2 or AVX-512, e.g. with -march=native)\n"
+        << "  --no-symmetry     test every machine, not just one of each family of symmetric copies (odometer)\n"
+        << "  --no-macro        run long-lived turmites one step at a time, without macro-steps (odometer)\n"
+        << "  --no-memo         run every turmite, even if an earlier one read the same transitions (odometer)\n"
+        << "  --no-prune        run every turmite, even if it can't get to its halt from the start (odometer)\n"
+        << "  --no-translation  run turmites that repeat a configuration shifted along until they leave the grid\n"
+        << "  --resume          continue an interrupted run from its checkpoint file\n"
+        << "  --stats           save counts of why turmites were rejected and how many steps they took to found_*.stats.jsonl\n"
+        << "  --log-halted N    also write every turmite that halts after N or more steps to found_*.jsonl (odometer)\n"
+        << "  --save-outcomes   write the outcome of every turmite tested to found_*.its<ITS>_r<R>.outcomes (odometer)\n"
+        << "  --reuse FILE      don't run the turmites whose outcome with --its and --radius is known from a file\n"
+        << "                    written by --save-outcomes (odometer)\n"
+        << "  --shard k/N       search only the k-th of N equal parts (k from 1 to N), for merge_shards\n"
+        << "  --states N        number of states (default: " << defaults.n_states << ")\n"
+        << "  --colors N        number of colors (default: " << defaults.n_colors << ")\n"
+        << "  --dims N          number of dimensions, square grids only (default: " << defaults.n_dims << ")\n"
+        << "  --absolute        absolute turmites: each move is a direction" << (defaults.relative ? "" : " (default)") << "\n"
+        << "  --relative        relative turmites: each move is a turn" << (defaults.relative ? " (default)" : "") << "\n"
+        << "  --its N           give up on a turmite after N steps (default: " << defaults.ITS << ")\n"
+        << "  --radius N        give up on a turmite that moves more than N cells from the start (default: " << defaults.R << ")\n"
+        << "  --unbounded       no radius: grow the grid as the turmite moves (not with --batch)\n"
+        << "  --memory MB       with --unbounded: give up on a turmite that needs more than MB of grid\n"
+        << "  --stages I:R,...  run every turmite with these cheaper budgets of steps and radius first, and only the\n"
+        << "                    ones that move off the grid or are still running again with the next (odometer)\n";
+}
+
+// reads the command line into options, which holds the searcher's defaults
+inline void parse_search_options(int argc,char *argv[],SearchOptions &options)
+{
+    const SearchOptions defaults = options;
+    for(int iArg=1;iArg<argc;iArg++)
+    {
+        if((strcmp(argv[iArg],"-t")==0 || strcmp(argv[iArg],"--threads")==0) && iArg+1<argc)
+            options.n_threads = atoi(argv[++iArg]);
+        else if(strcmp(argv[iArg],"--tree")==0)
+            options.tree = true;
+        else if(strcmp(argv[iArg],"--batch")==0)
+            options.batch = true;
+        else if(strcmp(argv[iArg],"--no-symmetry")==0)
+            options.symmetry = false;
+        else if(strcmp(argv[iArg],"--no-macro")==0)
+            options.macro = false;
+        else if(strcmp(argv[iArg],"--no-memo")==0)
+            options.memo = false;
+        else if(strcmp(argv[iArg],"--no-prune")==0)
+            options.prune = false;
+        else if(strcmp(argv[iArg],"--no-translation")==0)
+            options.translation = false;
+        else if(strcmp(argv[iArg],"--resume")==0)
+            options.resume = true;
+        else if(strcmp(argv[iArg],"--stats")==0)
+            options.stats = true;
+        else if(strcmp(argv[iArg],"--log-halted")==0 && iArg+1<argc)
+            options.log_halted = atoi(argv[++iArg]);
+        else if(strcmp(argv[iArg],"--save-outcomes")==0)
+            options.save_outcomes = true;
+        else if(strcmp(argv[iArg],"--reuse")==0 && iArg+1<argc)
+            options.reuse = argv[++iArg];
+        else if(strcmp(argv[iArg],"--shard")==0 && iArg+1<argc)
+        {
+            if(sscanf(argv[++iArg],"%d/%d",&options.shard,&options.n_shards)!=2
+                || options.n_shards<1 || options.shard<1 || options.shard>options.n_shards)
+            {
+                std::cout << "Expected --shard k/N with 1 <= k <= N." << std::endl;
+                exit(1);
+            }
+        }
+        else if(strcmp(argv[iArg],"--states")==0 && iArg+1<argc)
+            options.n_states = atoi(argv[++iArg]);
+        else if(strcmp(argv[iArg],"--colors")==0 && iArg+1<argc)
+            options.n_colors = atoi(argv[++iArg]);
+        else if(strcmp(argv[iArg],"--dims")==0 && iArg+1<argc)
+            options.n_dims = atoi(argv[++iArg]);
+        else if(strcmp(argv[iArg],"--absolute")==0)
+            options.relative = false;
+        else if(strcmp(argv[iArg],"--relative")==0)
+            options.relative = true;
+        else if(strcmp(argv[iArg],"--its")==0 && iArg+1<argc)
+            options.ITS = atoi(argv[++iArg]);
+        else if(strcmp(argv[iArg],"--radius")==0 && iArg+1<argc)
+            options.R = atoi(argv[++iArg]);
+        else if(strcmp(argv[iArg],"--unbounded")==0)
+            options.unbounded = true;
+        else if(strcmp(argv[iArg],"--memory")==0 && iArg+1<argc)
+            options.memory_mb = atoi(argv[++iArg]);
+        else if(strcmp(argv[iArg],"--stages")==0 && iArg+1<argc)
+        {
+            // e.g. 1000:10,100000:50 (with --unbounded there is no radius, so just 1000,100000)
+            options.stages.clear();
+            for(const char *p=argv[++iArg];;p++)
+            {
+                SearchBudget budget = {0,0};
+                int n_chars=0;
+                if(sscanf(p,"%d%n:%d%n",&budget.ITS,&n_chars,&budget.R,&n_chars)<1)
+                {
+                    std::cout << "Expected --stages ITS:R,ITS:R,... e.g. --stages 1000:10,100000:50" << std::endl;
+                    exit(1);
+                }
+                options.stages.push_back(budget);
+                p += n_chars;
+                if(*p!=',')
+                    break;
+            }
+        }
+        else
+        {
+            print_usage(argv[0],defaults);
+            exit(1);
+        }
+    }
+    if(options.n_threads<1)
+    {
+        std::cout << "Number of threads must be at least 1." << std::endl;
+        exit(1);
+    }
+    // (states and colors are stored in a byte of each transition, see transition_table.h, and the
+    // searchers' symmetry rules assume a second state)
+    if(options.n_states<2 || options.n_states>255)
+    {
+        std::cout << "Number of states must be from 2 to 255." << std::endl;
+        exit(1);
+    }
+    if(options.n_colors<2 || options.n_colors>255) // (the halt transition writes color 1)
+    {
+        std::cout << "Number of colors must be from 2 to 255." << std::endl;
+        exit(1);
+    }
+    if(options.n_dims<1)
+    {
+        std::cout << "Number of dimensions must be at least 1." << std::endl;
+        exit(1);
+    }
+    if(options.ITS<1 || options.R<1)
+    {
+        std::cout << "--its and --radius must be at least 1." << std::endl;
+        exit(1);
+    }
+    if(options.memory_mb<0)
+    {
+        std::cout << "--memory must be at least 0." << std::endl;
+        exit(1);
+    }
+    if(options.batch && (options.tree || options.unbounded))
+    {
+        std::cout << "--batch can't be used with --tree or --unbounded." << std::endl;
+        exit(1);
+    }
+    if(!options.stages.empty() && options.tree)
+    {
+        std::cout << "--stages can't be used with --tree." << std::endl;
+        exit(1);
+    }
+    if(options.log_halted>=0 && options.tree)
+    {
+        std::cout << "--log-halted can't be used with --tree." << std::endl;
+        exit(1);
+    }
+    if((options.save_outcomes || !options.reuse.empty()) && (options.tree || options.unbounded || !options.stages.empty()))
+    {
+        std::cout << "--save-outcomes and --reuse can't be used with --tree, --unbounded or --stages." << std::endl;
+        exit(1);
+    }
+    // each stage must be cheaper than the next, and the last of them cheaper than --its and --radius
+    for(size_t iStage=0;iStage<options.stages.size();iStage++)
+    {
+        if(options.stages[iStage].R==0 || options.unbounded)
+            options.stages[iStage].R = options.R; // (not given, or not used)
+    }
+    for(size_t iStage=0;iStage<options.stages.size();iStage++)
+    {
+        const SearchBudget &budget = options.stages[iStage];
+        const SearchBudget next = iStage+1<options.stages.size() ? options.stages[iStage+1] : SearchBudget{options.ITS,options.R};
+        if(budget.ITS<1 || budget.R<1 || budget.ITS>next.ITS || budget.R>next.R || (budget.ITS==next.ITS && budget.R==next.R))
+        {
+            std::cout << "Each of --stages must have fewer steps or a smaller radius than the next, and no more of either." << std::endl;
+            exit(1);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,101 @@
+// Where the time of a search goes.
+//
+// Each chunk counts why the machines it rules out fail the filters, and for each outcome of the
+// tested machines, a histogram of the number of steps they took to be decided, with a bucket for
+// each power of 2. The counts are merged as the chunks are committed (see parallel_search.h), and
+// with --stats a snapshot of the totals is saved now and then as a line of JSON, to show where the
+// budget goes and how ITS and R could be changed.
+
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+// STL:
+#include <ostream>
+
+// local:
+#include "turmite.h"
+
+struct SearchStats
+{
+    static const int N_OUTCOMES = 4; // HALTED, OFF_GRID, CYCLED and TIMED_OUT (see turmite.h)
+    static const int N_BUCKETS = 32; // bucket 0 is 0 steps, bucket b is 2^(b-1) to 2^b-1 steps
+
+    // the odometer's filters, in the order they are checked (the tree search rules out whole
+    // subtrees at once, so it doesn't count these)
+    unsigned long long n_halts_filtered; // not exactly one halting transition
+    unsigned long long halt_filtered; // the halting transition isn't {1,0,0}
+    unsigned long long rule_filtered; // ruled out by the front end's rules about single transitions
+    unsigned long long symmetry_filtered; // a copy of an earlier machine (see symmetry.h)
+    unsigned long long reachability_filtered; // can never reach its halt (see reachability.h)
+
+    unsigned long long memo_hits; // tested without being run (see outcome_memo.h)
+    unsigned long long reused; // tested without being run, with --reuse (see outcome_store.h)
+    unsigned long long steps[N_OUTCOMES]; // the total steps taken by the machines with each outcome
+    unsigned long long histogram[N_OUTCOMES][N_BUCKETS];
+
+    SearchStats() : n_halts_filtered(0),halt_filtered(0),rule_filtered(0),symmetry_filtered(0),reachability_filtered(0),memo_hits(0),reused(0)
+    {
+        for(int iOutcome=0;iOutcome<N_OUTCOMES;iOutcome++)
+        {
+            steps[iOutcome] = 0;
+            for(int iBucket=0;iBucket<N_BUCKETS;iBucket++)
+                histogram[iOutcome][iBucket] = 0;
+        }
+    }
+
+    // n machines were decided with this outcome after its steps
+    void count(RunOutcome outcome,int its,unsigned long long n)
+    {
+        if(outcome>=N_OUTCOMES)
+            return;
+        int iBucket=0;
+        while(iBucket<N_BUCKETS-1 && (its>>iBucket)>0)
+            iBucket++;
+        steps[outcome] += n*(unsigned long long)its;
+        histogram[outcome][iBucket] += n;
+    }
+
+    void add(const SearchStats &other)
+    {
+        n_halts_filtered += other.n_halts_filtered;
+        halt_filtered += other.halt_filtered;
+        rule_filtered += other.rule_filtered;
+        symmetry_filtered += other.symmetry_filtered;
+        reachability_filtered += other.reachability_filtered;
+        memo_hits += other.memo_hits;
+        reused += other.reused;
+        for(int iOutcome=0;iOutcome<N_OUTCOMES;iOutcome++)
+        {
+            steps[iOutcome] += other.steps[iOutcome];
+            for(int iBucket=0;iBucket<N_BUCKETS;iBucket++)
+                histogram[iOutcome][iBucket] += other.histogram[iOutcome][iBucket];
+        }
+    }
+
+    // writes the counts as fields of a JSON object, with the histograms cut short after their last
+    // non-empty bucket
+    void write_fields(std::ostream &out) const
+    {
+        static const char *OUTCOME_NAMES[N_OUTCOMES] = {"halted","off_grid","cycled","timed_out"};
+        out << "\"filtered\":{\"n_halts\":" << n_halts_filtered << ",\"halt\":" << halt_filtered
+            << ",\"rules\":" << rule_filtered << ",\"symmetry\":" << symmetry_filtered
+            << ",\"reachability\":" << reachability_filtered << "},\"memo_hits\":" << memo_hits << ",\"reused\":" << reused;
+        for(int iOutcome=0;iOutcome<N_OUTCOMES;iOutcome++)
+        {
+            unsigned long long n=0;
+            int n_buckets=0;
+            for(int iBucket=0;iBucket<N_BUCKETS;iBucket++)
+            {
+                n += histogram[iOutcome][iBucket];
+                if(histogram[iOutcome][iBucket]>0)
+                    n_buckets = iBucket+1;
+            }
+            out << ",\"" << OUTCOME_NAMES[iOutcome] << "\":{\"count\":" << n << ",\"steps\":" << steps[iOutcome] << ",\"histogram\":[";
+            for(int iBucket=0;iBucket<n_buckets;iBucket++)
+                out << (iBucket>0 ? "," : "") << histogram[iOutcome][iBucket];
+            out << "]}";
+        }
+    }
+};
+
+#endif
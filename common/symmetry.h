@@ -0,0 +1,198 @@
+// Skipping turmites that are copies of others up to symmetry.
+//
+// Two turmites take the same number of steps, reach the same population and stop for the same
+// reason if one is the other with its states 1..N-1 renumbered, its colors 1..N-1 renumbered (0 is
+// the empty cell) or its moves changed by a symmetry of the grid (see grid_topology.h). So the
+// odometer only needs to run one turmite of each family: the one that comes first in the odometer
+// among those that pass the searcher's other filters (possible_entries, allowed() and a single
+// halt at {1,0,0}). The records, which are the first machines to reach each score, don't change.
+//
+// A machine is skipped if a symmetry maps it to a passing machine that comes earlier. This is
+// checked before the machine is run, comparing from the most significant digit of the odometer so
+// that most symmetries are ruled out after a digit or two. Since the halt writes color 1, only the
+// colors 2..N-1 are renumbered. With many states or colors only swaps of neighbouring numbers are
+// used, rather than every renumbering: fewer machines are skipped, but never a whole family.
+
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+// STL:
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+// local:
+#include "grid_topology.h"
+
+class SymmetryFilter
+{
+    public:
+
+        // allowed() as for the searchers (returns false to rule out a transition)
+        SymmetryFilter(const std::vector<std::vector<unsigned char> > &possible_entries,int n_states,int n_colors,
+            const MoveSymmetries &move_symmetries,std::function<bool(int,unsigned char,unsigned char,unsigned char)> allowed)
+            : possible_entries(possible_entries),n_colors(n_colors),slot_allowed(possible_entries.size()/3)
+        {
+            // allowed(), for each slot and combination of its digits
+            for(size_t iSlot=0;iSlot<slot_allowed.size();iSlot++)
+            {
+                const std::vector<unsigned char> &colors = possible_entries[iSlot*3+0];
+                const std::vector<unsigned char> &moves = possible_entries[iSlot*3+1];
+                const std::vector<unsigned char> &states = possible_entries[iSlot*3+2];
+                for(size_t iState=0;iState<states.size();iState++)
+                    for(size_t iMove=0;iMove<moves.size();iMove++)
+                        for(size_t iColor=0;iColor<colors.size();iColor++)
+                            slot_allowed[iSlot].push_back(allowed((int)iSlot,colors[iColor],moves[iMove],states[iState]));
+            }
+            const std::vector<std::vector<unsigned char> > states = renumberings(n_states,1);
+            const std::vector<std::vector<unsigned char> > colors = renumberings(n_colors,2);
+            // every combination if there aren't too many, else one kind of symmetry at a time
+            if(states.size()*colors.size()*move_symmetries.size()<=MAX_COMBINATIONS)
+            {
+                for(size_t iState=0;iState<states.size();iState++)
+                    for(size_t iColor=0;iColor<colors.size();iColor++)
+                        for(size_t iMove=0;iMove<move_symmetries.size();iMove++)
+                            if(iState>0 || iColor>0 || iMove>0) // (not the identity)
+                                add(states[iState],colors[iColor],move_symmetries[iMove]);
+            }
+            else
+            {
+                for(size_t iState=1;iState<states.size();iState++)
+                    add(states[iState],colors[0],move_symmetries[0]);
+                for(size_t iColor=1;iColor<colors.size();iColor++)
+                    add(states[0],colors[iColor],move_symmetries[0]);
+                for(size_t iMove=1;iMove<move_symmetries.size();iMove++)
+                    add(states[0],colors[0],move_symmetries[iMove]);
+            }
+        }
+
+        // the number of symmetries used (not counting the identity)
+        size_t size() const { return symmetries.size(); }
+
+        // false if the machine (indices into possible_entries) has a symmetric copy that passes the
+        // filters and comes earlier in the odometer
+        bool first_of_family(const unsigned char *turmite) const
+        {
+            const int n_entries = (int)possible_entries.size();
+            for(size_t iSymmetry=0;iSymmetry<symmetries.size();iSymmetry++)
+            {
+                const Symmetry &symmetry = symmetries[iSymmetry];
+                int iEntry,digit=0;
+                for(iEntry=n_entries-1;iEntry>=0;iEntry--)
+                {
+                    digit = symmetry.digits[symmetry.first[iEntry] + turmite[symmetry.source[iEntry]]];
+                    if(digit!=turmite[iEntry])
+                        break;
+                }
+                if(iEntry<0 || digit<0 || digit>turmite[iEntry])
+                    continue; // the copy is the same machine, isn't a possible machine or comes later
+                if(passes(symmetry,turmite))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+
+        static const size_t MAX_COMBINATIONS = 10000;
+        static const int MAX_RENUMBERED = 5; // beyond this only swap neighbours
+
+        // The renumberings of 0..n-1 that keep 0..n_fixed-1 where they are, the identity first: every
+        // one if there are few, else the swaps of neighbouring numbers.
+        static std::vector<std::vector<unsigned char> > renumberings(int n,int n_fixed)
+        {
+            std::vector<std::vector<unsigned char> > result;
+            std::vector<unsigned char> numbers(n);
+            for(int i=0;i<n;i++)
+                numbers[i] = (unsigned char)i;
+            if(n-n_fixed<=MAX_RENUMBERED)
+            {
+                do
+                    result.push_back(numbers);
+                while(std::next_permutation(numbers.begin()+std::min(n_fixed,n),numbers.end()));
+            }
+            else
+            {
+                result.push_back(numbers);
+                for(int i=n_fixed;i+1<n;i++)
+                {
+                    result.push_back(numbers);
+                    std::swap(result.back()[i],result.back()[i+1]);
+                }
+            }
+            return result;
+        }
+
+        // a symmetry, as a map from the digits of a machine to the digits of its copy
+        struct Symmetry
+        {
+            std::vector<int> source; // entry iEntry of the copy comes from entry source[iEntry] of the machine
+            std::vector<int> first; // where the digits of entry iEntry start
+            std::vector<short> digits; // the copy's digit for each digit of the source, or -1 if not possible
+        };
+
+        // adds the symmetry that renumbers the states and colors and changes the moves, unless it can
+        // never give a passing machine
+        void add(const std::vector<unsigned char> &state,const std::vector<unsigned char> &color,const std::vector<unsigned char> &move)
+        {
+            const int n_entries = (int)possible_entries.size();
+            std::vector<unsigned char> color_from(color.size()),state_from(state.size()); // the inverse renumberings
+            for(size_t i=0;i<color.size();i++)
+                color_from[color[i]] = (unsigned char)i;
+            for(size_t i=0;i<state.size();i++)
+                state_from[state[i]] = (unsigned char)i;
+            Symmetry symmetry;
+            for(int iEntry=0;iEntry<n_entries;iEntry++)
+            {
+                // the slot (state,color) of the copy holds the renumbered transition of the slot
+                // (state_from[state],color_from[color]) of the machine
+                const int iSlot = iEntry/3, which = iEntry%3;
+                const int iSource = (state_from[iSlot/n_colors]*n_colors + color_from[iSlot%n_colors])*3 + which;
+                const std::vector<unsigned char> &values = possible_entries[iSource];
+                const std::vector<unsigned char> &copy_values = possible_entries[iEntry];
+                const std::vector<unsigned char> &renumber = which==0 ? color : which==1 ? move : state;
+                symmetry.source.push_back(iSource);
+                symmetry.first.push_back((int)symmetry.digits.size());
+                bool any = false;
+                for(size_t iDigit=0;iDigit<values.size();iDigit++)
+                {
+                    const std::vector<unsigned char>::const_iterator found =
+                        std::find(copy_values.begin(),copy_values.end(),renumber[values[iDigit]]);
+                    symmetry.digits.push_back(found==copy_values.end() ? -1 : (short)(found-copy_values.begin()));
+                    any = any || found!=copy_values.end();
+                }
+                if(!any)
+                    return; // every machine's copy has an impossible entry
+            }
+            symmetries.push_back(symmetry);
+        }
+
+        // whether the symmetric copy of the machine passes the filters (the copy of the single halt
+        // at {1,0,0} is itself, so only possible_entries and allowed() need checking)
+        bool passes(const Symmetry &symmetry,const unsigned char *turmite) const
+        {
+            const int n_slots = (int)possible_entries.size()/3;
+            for(int iSlot=0;iSlot<n_slots;iSlot++)
+            {
+                int digit[3];
+                for(int which=0;which<3;which++)
+                {
+                    const int iEntry = iSlot*3+which;
+                    digit[which] = symmetry.digits[symmetry.first[iEntry] + turmite[symmetry.source[iEntry]]];
+                    if(digit[which]<0)
+                        return false;
+                }
+                if(!slot_allowed[iSlot][digit[0] + possible_entries[iSlot*3+0].size()
+                    *(digit[1] + possible_entries[iSlot*3+1].size()*digit[2])])
+                    return false;
+            }
+            return true;
+        }
+
+        const std::vector<std::vector<unsigned char> > possible_entries;
+        const int n_colors;
+        std::vector<std::vector<bool> > slot_allowed; // (as in search_turmites)
+        std::vector<Symmetry> symmetries;
+};
+
+#endif
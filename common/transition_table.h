@@ -0,0 +1,80 @@
+// A turmite compiled into a flat table with one word per (state,color).
+//
+// The odometer stores each turmite as indices into possible_entries, which costs two lookups for
+// each of the color, move and state of a transition. Here each transition is packed into a single
+// word holding the color to write, the move (a direction or a turn) and the next state, so that a
+// simulation step needs only one load. When the odometer changes some digits, only the transitions
+// that contain them need to be rewritten.
+//
+// Each state has a row of N_COLORS+1 words: its transitions for each color, then OFF_GRID for the
+// color N_COLORS, which the border of a dense grid is painted with (see turmite_engine.h). So a
+// turmite that steps onto the border finds out from the same load, with no check of its own.
+
+#ifndef TRANSITION_TABLE_H
+#define TRANSITION_TABLE_H
+
+// STL:
+#include <vector>
+
+class TransitionTable
+{
+    public:
+
+        typedef unsigned int Transition;
+
+        static const Transition UNDEFINED = 0xffffffff; // not chosen yet (see tree_search.h)
+        static const Transition OFF_GRID = 0xfffffffe; // for a cell outside the grid (no transition is this big)
+
+        static unsigned char color(Transition t) { return t & 0xff; }
+        static unsigned char move(Transition t) { return (t >> 8) & 0xff; }
+        static unsigned char state(Transition t) { return (t >> 16) & 0xff; }
+
+        // possible_entries must outlive the table, every transition starts undefined
+        TransitionTable(const std::vector<std::vector<unsigned char> >& possible_entries,int n_colors)
+            : possible_entries(possible_entries),n_colors(n_colors),
+            table(possible_entries.size()/3 + possible_entries.size()/3/n_colors,Transition(UNDEFINED))
+        {
+            for(size_t iEntry=n_colors;iEntry<table.size();iEntry+=n_colors+1)
+                table[iEntry] = OFF_GRID;
+        }
+
+        // rewrite every transition (turmite[i] is an index into possible_entries[i])
+        void compile(const unsigned char *turmite)
+        {
+            for(size_t iSlot=0;iSlot<possible_entries.size()/3;iSlot++)
+                update(iSlot,turmite);
+        }
+
+        // rewrite the transition for one (state,color) after its digits have changed
+        void update(size_t iSlot,const unsigned char *turmite)
+        {
+            const size_t iEntry = iSlot*3;
+            table[iSlot+iSlot/n_colors] = possible_entries[iEntry+0][turmite[iEntry+0]]
+                | possible_entries[iEntry+1][turmite[iEntry+1]] << 8
+                | possible_entries[iEntry+2][turmite[iEntry+2]] << 16;
+        }
+
+        void undefine(size_t iSlot) { table[iSlot+iSlot/n_colors] = UNDEFINED; }
+
+        // the odometer has just incremented digit iEntry, resetting all the digits below it
+        void update_after_increment(size_t iEntry,const unsigned char *turmite)
+        {
+            for(size_t iSlot=0;iSlot<=iEntry/3;iSlot++)
+                update(iSlot,turmite);
+        }
+
+        // The transition for (state,color) is at iSlot+state, where iSlot = state*N_COLORS + color.
+        // Color N_COLORS gives OFF_GRID.
+        Transition operator[](size_t iEntry) const { return table[iEntry]; }
+
+        // the number of words, N_STATES*(N_COLORS+1)
+        size_t size() const { return table.size(); }
+
+    private:
+
+        const std::vector<std::vector<unsigned char> >& possible_entries;
+        const size_t n_colors;
+        std::vector<Transition> table;
+};
+
+#endif
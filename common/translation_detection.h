@@ -0,0 +1,272 @@
+// Detection of turmites that repeat a configuration shifted across the grid.
+//
+// A turmite that builds a highway (as Langton's ant does after about 10000 steps), or that drifts
+// away while going through the same motions, never returns to an earlier configuration, so
+// cycle_detection.h doesn't catch it: it runs until it moves off the grid or reaches ITS. But it
+// returns to one shifted along, and that can be caught too.
+//
+// When the turmite gets further along an axis than it has been before (a record), the cells ahead
+// of it are all still color 0. Say it sets records in the same direction at steps t1 and t2, in the
+// same state and direction, having been at most L cells behind the first record in between. If
+// every cell at most L cells behind the turmite (or anywhere ahead of it) has the same color at t2
+// as the cell in the same place relative to the turmite had at t1, then the steps from t2 read the
+// same colors as those from t1, shifted along, and at step 2*t2-t1 the same holds again: the
+// turmite never halts. (On a finite grid it would move off it in the end.)
+//
+// A snapshot is taken at every RECORD_EVERY-th cell along each direction from the start (a
+// turmite that repeats a configuration shifted along repeats it at those too, only further on). It
+// holds a hash of the state, the direction and the colors of the cells level with the turmite,
+// and the colors of the cells just behind it. An earlier snapshot in the same direction that
+// matches, as far as the turmite has been back, is compared in full, cell by cell, from the journal
+// of the grid (see journal_grid.h). That stops at the first cell that differs, but can take time
+// in proportion to the writes so far, so after a comparison that fails there isn't another until
+// the turmite has taken COMPARISON_COST steps for every cell it looked at. A snapshot is dropped
+// once the turmite has been more than MAX_DEPTH cells behind it, and at most MAX_SNAPSHOTS are
+// kept in each direction. On the triangular grid only cells that point the same way are compared,
+// so that the shift is a symmetry of the grid.
+//
+// Most turmites halt, cycle or move off the grid within a few dozen steps, and they shouldn't pay
+// for any of this, so a turmite is only followed once it has taken FOLLOW_AFTER steps (one that
+// drifts off a grid before then is counted as having moved off it, as without the detector). Its
+// records are then the box of the cells it has written so far, beyond which every cell is still
+// color 0. From there on the detector only follows how far back the turmite goes between records,
+// and while it stays inside the box it has been around since the last snapshots there is nothing
+// to do, so room() tells the caller how many steps it can skip (see turmite_engine.h).
+
+#ifndef TRANSLATION_DETECTION_H
+#define TRANSLATION_DETECTION_H
+
+// STL:
+#include <algorithm>
+#include <vector>
+
+class TranslationDetector
+{
+    public:
+
+        static const int MAX_DIMS = 6; // (the most that the square searcher offers)
+        static const int MAX_DIRS = 2*MAX_DIMS;
+        static const int MAX_DEPTH = 32;
+        static const int MAX_SNAPSHOTS = 16;
+        static const int BEHIND = 8,ACROSS = 3; // how far the lines of cells compared first go (see Snapshot)
+        static const int COMPARISON_COST = 4; // after a full comparison that fails, wait this many steps for each cell it looked at
+        static const int RECORD_EVERY = 4; // only records this many cells apart are looked at
+        static const int FOLLOW_AFTER = 1<<7; // the steps a turmite takes before it is followed
+
+        // the turmite has just started
+        void reset() { followed = false; }
+
+        // Start following the turmite, which started at origin and is at pos, with the cells it has
+        // written inside the box [lo,hi] (which holds pos).
+        template<int N_DIM>
+        void follow(const int *origin,const int *lo,const int *hi,const int *pos)
+        {
+            for(int iDim=0;iDim<N_DIM;iDim++)
+            {
+                this->origin[iDim] = origin[iDim];
+                this->lo[iDim] = lo[iDim];
+                this->hi[iDim] = hi[iDim];
+                lowest[iDim] = highest[iDim] = pos[iDim];
+            }
+            for(int direction=0;direction<2*N_DIM;direction++)
+                snapshots[direction].clear();
+            next_comparison = 0;
+            followed = true;
+        }
+
+        bool following() const { return followed; }
+
+        // Once the turmite is followed, call for every step that room() doesn't allow to skip, with
+        // the configuration before the step is taken (as for CycleDetector). color_at(pos) gives the
+        // color of the cell at pos, and 0 for a cell that isn't on the grid (nothing can have been
+        // written there), so that what is found doesn't depend on the size of the grid.
+        // position(iCell,pos) gives the position of a cell. Returns true if the configuration is
+        // that of an earlier record, shifted along (see above).
+        template<class Topology,class Grid,class ColorAt,class Position>
+        bool repeated(int its,const int *pos,int state,int dir,Grid &grid,ColorAt color_at,Position position)
+        {
+            bool record = false;
+            for(int iDim=0;iDim<Topology::N_DIM;iDim++)
+            {
+                lowest[iDim] = std::min(lowest[iDim],pos[iDim]);
+                highest[iDim] = std::max(highest[iDim],pos[iDim]);
+                record |= (pos[iDim]>hi[iDim]) | (pos[iDim]<lo[iDim]);
+            }
+            return record && new_record<Topology>(its,pos,state,dir,grid,color_at,position);
+        }
+
+        // how many steps that move at most one cell along each axis the turmite at pos can take
+        // before repeated() has anything to do again: it stays inside the box of lowest and highest
+        template<int N_DIM>
+        int room(const int *pos) const
+        {
+            int n = std::min(pos[0]-lowest[0],highest[0]-pos[0]);
+            for(int iDim=1;iDim<N_DIM;iDim++)
+                n = std::min(n,std::min(pos[iDim]-lowest[iDim],highest[iDim]-pos[iDim]));
+            return n;
+        }
+
+    private:
+
+        struct Snapshot
+        {
+            unsigned long long key; // a hash of everything that has to match whatever the depth (see level_key())
+            int pos[MAX_DIMS];
+            int deepest; // the furthest back the turmite has been since, measured along the direction
+            size_t mark; // the grid's mark() at the time
+            unsigned char around[MAX_DIRS]; // the color of the cell in each direction from the turmite
+            unsigned char behind[BEHIND]; // the colors of the cells 1, 2, ... behind the turmite along the axis
+        };
+
+        template<class Topology,class Grid,class ColorAt,class Position>
+        bool new_record(int its,const int *pos,int state,int dir,Grid &grid,ColorAt color_at,Position position)
+        {
+            const int N_DIM = Topology::N_DIM;
+            Snapshot now;
+            int offsets[MAX_DIRS][MAX_DIMS]; // where each direction from the turmite leads
+            bool taken = false; // (now is only filled in for the first direction that it is needed for)
+            for(int iDim=0;iDim<N_DIM;iDim++)
+            {
+                for(int sign=1;sign>=-1;sign-=2)
+                {
+                    if(sign*pos[iDim] <= (sign>0 ? hi[iDim] : -lo[iDim]))
+                        continue; // not a record in this direction
+                    (sign>0 ? hi : lo)[iDim] = pos[iDim];
+                    if(sign*(pos[iDim]-origin[iDim])%RECORD_EVERY!=0)
+                        continue;
+                    if(!taken)
+                    {
+                        std::copy(pos,pos+N_DIM,now.pos);
+                        now.mark = grid.mark();
+                        for(int iDir=0;iDir<Topology::N_DIRS;iDir++)
+                        {
+                            int next[MAX_DIMS];
+                            std::copy(pos,pos+N_DIM,next);
+                            Topology::step(next,iDir+1);
+                            now.around[iDir] = (unsigned char)color_at(next);
+                            for(int jDim=0;jDim<N_DIM;jDim++)
+                                offsets[iDir][jDim] = next[jDim]-pos[jDim];
+                        }
+                        taken = true;
+                    }
+                    std::vector<Snapshot> &earlier = snapshots[2*iDim+(sign<0)];
+                    now.deepest = sign*pos[iDim];
+                    now.key = level_key<Topology>(now,offsets,iDim,state,dir,color_at);
+                    for(int i=0;i<BEHIND;i++)
+                    {
+                        int cell[MAX_DIMS];
+                        std::copy(pos,pos+N_DIM,cell);
+                        cell[iDim] -= sign*(i+1);
+                        now.behind[i] = (unsigned char)color_at(cell);
+                    }
+                    // the furthest back since the last snapshot in this direction
+                    const int since = sign>0 ? lowest[iDim] : -highest[iDim];
+                    int n_kept=0;
+                    for(int iSnapshot=(int)earlier.size()-1;iSnapshot>=0;iSnapshot--) // (newest first)
+                    {
+                        Snapshot &old = earlier[iSnapshot];
+                        old.deepest = std::min(old.deepest,since);
+                        const int depth = sign*old.pos[iDim]-old.deepest;
+                        if(depth>MAX_DEPTH || ++n_kept>=MAX_SNAPSHOTS)
+                        {
+                            earlier.erase(earlier.begin()+iSnapshot);
+                            continue;
+                        }
+                        if(old.key!=now.key || its<next_comparison)
+                            continue;
+                        // the cells behind the turmite that it has been back to
+                        bool same = std::equal(now.behind,now.behind+std::min(depth,(int)BEHIND),old.behind);
+                        for(int iDir=0;iDir<Topology::N_DIRS && same;iDir++)
+                            same = sign*offsets[iDir][iDim]>=0 || sign*offsets[iDir][iDim]<-depth || old.around[iDir]==now.around[iDir];
+                        if(!same)
+                            continue;
+                        size_t n_cells=0;
+                        if(same_behind<N_DIM>(old,pos,iDim,sign,depth,grid,color_at,position,n_cells))
+                            return true;
+                        next_comparison = its+COMPARISON_COST*(long long)n_cells;
+                    }
+                    earlier.push_back(now);
+                    (sign>0 ? lowest : highest)[iDim] = pos[iDim];
+                }
+            }
+            return false;
+        }
+
+        // A hash of the state, the direction, on the triangular grid which way the turmite's cell
+        // points, and the colors of the cells level with it along the axis: its neighbours and the
+        // cells up to ACROSS away along each other axis. (The cells ahead of it are all color 0.)
+        template<class Topology,class ColorAt>
+        static unsigned long long level_key(const Snapshot &now,const int (*offsets)[MAX_DIMS],int axis,int state,int dir,ColorAt color_at)
+        {
+            const int N_DIM = Topology::N_DIM;
+            const unsigned long long MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+            unsigned long long key = (unsigned long long)state*MULTIPLIER + dir;
+            if(Topology::STEP_PARITY)
+                key = key*MULTIPLIER + (parity<N_DIM>(now.pos)+1);
+            for(int iDir=0;iDir<Topology::N_DIRS;iDir++)
+                if(offsets[iDir][axis]==0)
+                    key = key*MULTIPLIER + now.around[iDir];
+            int cell[MAX_DIMS];
+            std::copy(now.pos,now.pos+N_DIM,cell);
+            for(int iDim=0;iDim<N_DIM;iDim++)
+            {
+                if(iDim==axis)
+                    continue;
+                for(int i=-ACROSS;i<=ACROSS;i++)
+                {
+                    cell[iDim] = now.pos[iDim]+i;
+                    key = key*MULTIPLIER + color_at(cell);
+                }
+                cell[iDim] = now.pos[iDim];
+            }
+            return key;
+        }
+
+        // whether every cell at most depth behind the turmite along the axis (or ahead of it) has
+        // the color that the cell in the same place relative to it had at the snapshot; adds the
+        // number of cells looked at to n_cells
+        template<int N_DIM,class Grid,class ColorAt,class Position>
+        bool same_behind(const Snapshot &old,const int *pos,int axis,int sign,int depth,Grid &grid,ColorAt color_at,Position position,size_t &n_cells)
+        {
+            // Each cell that wasn't color 0 then must have its color now, shifted along, and there
+            // must be as many that aren't color 0 now. (Every cell that isn't color 0 has been written.)
+            int shift[MAX_DIMS],cell[MAX_DIMS];
+            for(int iDim=0;iDim<N_DIM;iDim++)
+                shift[iDim] = pos[iDim]-old.pos[iDim];
+            unsigned int n_then=0,n_now=0;
+            bool same = true;
+            n_cells += grid.for_each_written_cell(old.mark,[&](unsigned int iCell,unsigned char then)
+            {
+                position(iCell,cell);
+                if(grid[iCell]!=0 && sign*(cell[axis]-pos[axis])>=-depth)
+                    n_now++;
+                if(then!=0 && sign*(cell[axis]-old.pos[axis])>=-depth)
+                {
+                    n_then++;
+                    for(int iDim=0;iDim<N_DIM;iDim++)
+                        cell[iDim] += shift[iDim];
+                    same = color_at(cell)==then;
+                }
+                return same;
+            });
+            return same && n_then==n_now;
+        }
+
+        template<int N_DIM>
+        static int parity(const int *pos)
+        {
+            int sum=0;
+            for(int iDim=0;iDim<N_DIM;iDim++)
+                sum += pos[iDim];
+            return sum&1;
+        }
+
+        int origin[MAX_DIMS]; // where the turmite started
+        int lo[MAX_DIMS],hi[MAX_DIMS]; // the furthest the turmite has been along each axis
+        int lowest[MAX_DIMS],highest[MAX_DIMS]; // the furthest back since the last snapshot along +axis, and along -axis
+        std::vector<Snapshot> snapshots[MAX_DIRS]; // for a record along +axis at [2*axis], along -axis at [2*axis+1], oldest first
+        long long next_comparison; // the step before which no cells are compared in full
+        bool followed; // whether follow() has been called since reset()
+};
+
+#endif
@@ -0,0 +1,308 @@
+// Tree-normal-form enumeration of turmites.
+//
+// Instead of testing every complete assignment of the turmite[] digits, we start with every
+// transition undefined and run the turmite until it reads a (state,color) whose transition hasn't
+// been chosen yet. We then branch over the possible values of that transition, continuing each
+// branch from the saved configuration rather than from the start. When a turmite halts, leaves the
+// grid or runs out of steps, the result holds for every choice of the transitions it never used, so
+// that whole subtree is decided at once.
+//
+// Machines are filtered as for the odometer: exactly one halting transition, which must be {1,0,0},
+// plus any constraints on single transitions that the searcher adds. The tried and tested counts
+// come out the same as the odometer's, but the records are found in a different order.
+
+#ifndef TREE_SEARCH_H
+#define TREE_SEARCH_H
+
+// STL:
+#include <functional>
+#include <vector>
+
+// local:
+#include "journal_grid.h"
+#include "parallel_search.h"
+#include "transition_table.h"
+#include "turmite.h"
+
+// Grid is the kind of JournalGrid that the turmites are run on (see journal_grid.h).
+template<class Grid>
+class BasicTreeSearch
+{
+    public:
+
+        typedef std::function<void(TurmiteState&)> StartFunction;
+        typedef std::function<RunOutcome(const TransitionTable&,Grid&,TurmiteState&)> RunFunction;
+        // returns false to rule out the transition (color,move,state) for the given slot
+        typedef std::function<bool(int,unsigned char,unsigned char,unsigned char)> TransitionFilter;
+        // fills in more of a chunk record from the grid it halted on (e.g. its cells, for a picture)
+        typedef std::function<void(const Grid&,FoundRecord&)> RecordFunction;
+
+        // start() puts a turmite in its initial state, run() continues it on the grid until it stops
+        BasicTreeSearch(const std::vector<std::vector<unsigned char> >& possible_entries,int n_colors,
+            TransitionFilter allowed,StartFunction start,RunFunction run,RecordFunction on_record=RecordFunction())
+            : possible_entries(possible_entries),n_colors(n_colors),start(start),run(run),on_record(on_record)
+        {
+            const size_t n_slots = possible_entries.size()/3;
+            choices.resize(n_slots);
+            n_combinations.resize(n_slots);
+            n_nonhalting.assign(n_slots,0);
+            can_halt.assign(n_slots,false);
+            for(size_t iSlot=0;iSlot<n_slots;iSlot++)
+            {
+                const std::vector<unsigned char> &colors = possible_entries[iSlot*3+0];
+                const std::vector<unsigned char> &moves = possible_entries[iSlot*3+1];
+                const std::vector<unsigned char> &states = possible_entries[iSlot*3+2];
+                n_combinations[iSlot] = colors.size()*moves.size()*states.size();
+                // in odometer order, the color digit changing fastest
+                for(size_t iState=0;iState<states.size();iState++)
+                {
+                    for(size_t iMove=0;iMove<moves.size();iMove++)
+                    {
+                        for(size_t iColor=0;iColor<colors.size();iColor++)
+                        {
+                            if(!allowed((int)iSlot,colors[iColor],moves[iMove],states[iState]))
+                                continue;
+                            Choice choice;
+                            choice.digits[0] = (unsigned char)iColor;
+                            choice.digits[1] = (unsigned char)iMove;
+                            choice.digits[2] = (unsigned char)iState;
+                            choice.halts = (moves[iMove]==0);
+                            if(choice.halts && !(colors[iColor]==1 && states[iState]==0))
+                                continue; // the halt triple should be {1,0,0}
+                            choices[iSlot].push_back(choice);
+                            if(choice.halts)
+                                can_halt[iSlot] = true;
+                            else
+                                n_nonhalting[iSlot]++;
+                        }
+                    }
+                }
+            }
+            Node root;
+            root.turmite.assign(possible_entries.size(),0);
+            root.defined.assign(n_slots,false);
+            root.n_halts = 0;
+            frontier.push_back(root);
+        }
+
+        // Expands the top of the tree until there are at least n_wanted subtrees (or nothing left to
+        // expand), to be searched as separate chunks. Returns the number of machines ruled out by the
+        // filter at the expanded nodes, which no chunk will count.
+        unsigned long long split(size_t n_wanted,Grid &grid)
+        {
+            unsigned long long n_ruled_out = 0;
+            TransitionTable transitions(possible_entries,n_colors);
+            TurmiteState t;
+            while(frontier.size()<n_wanted)
+            {
+                std::vector<Node> next;
+                bool expanded = false;
+                for(size_t iNode=0;iNode<frontier.size();iNode++)
+                {
+                    Node &node = frontier[iNode];
+                    if(replay(node,transitions,grid,t)!=UNDEFINED_TRANSITION)
+                    {
+                        next.push_back(node); // already decided
+                        continue;
+                    }
+                    n_ruled_out += n_ruled_out_at(node,t.slot);
+                    for(size_t iChoice=0;iChoice<choices[t.slot].size();iChoice++)
+                    {
+                        next.push_back(node);
+                        define(next.back(),t.slot,choices[t.slot][iChoice]);
+                        if(n_passing_below(next.back())==0)
+                        {
+                            n_ruled_out += n_below(next.back(),-1); // no need to run it
+                            next.pop_back();
+                        }
+                    }
+                    expanded = true;
+                }
+                frontier.swap(next);
+                if(!expanded)
+                    break;
+            }
+            return n_ruled_out;
+        }
+
+        size_t n_chunks() const { return frontier.size(); }
+
+        void search_chunk(size_t iChunk,Grid &grid,ChunkResult &result)
+        {
+            Node node = frontier[iChunk];
+            TransitionTable transitions(possible_entries,n_colors);
+            TurmiteState t;
+            int max_its=-1,max_nonzero=-1;
+            prepare(node,transitions,grid,t);
+            explore(node,transitions,grid,t,result,max_its,max_nonzero);
+        }
+
+    private:
+
+        // a possible value of one transition, as indices into possible_entries
+        struct Choice
+        {
+            unsigned char digits[3];
+            bool halts;
+        };
+
+        // a turmite with only some of its transitions chosen
+        struct Node
+        {
+            std::vector<unsigned char> turmite; // turmite[i] is an index into possible_entries[i]
+            std::vector<bool> defined; // for each slot
+            int n_halts; // the number of defined transitions that halt
+        };
+
+        void define(Node &node,int iSlot,const Choice &choice)
+        {
+            for(int i=0;i<3;i++)
+                node.turmite[iSlot*3+i] = choice.digits[i];
+            node.defined[iSlot] = true;
+            if(choice.halts)
+                node.n_halts++;
+        }
+
+        void undefine(Node &node,int iSlot,const Choice &choice)
+        {
+            node.defined[iSlot] = false;
+            if(choice.halts)
+                node.n_halts--;
+        }
+
+        // puts the node's turmite at the start, on a clear grid
+        void prepare(const Node &node,TransitionTable &transitions,Grid &grid,TurmiteState &t)
+        {
+            for(size_t iSlot=0;iSlot<node.defined.size();iSlot++)
+            {
+                if(node.defined[iSlot])
+                    transitions.update(iSlot,&node.turmite[0]);
+                else
+                    transitions.undefine(iSlot);
+            }
+            grid.clear();
+            start(t);
+        }
+
+        // runs the node's turmite from the start until it stops
+        RunOutcome replay(const Node &node,TransitionTable &transitions,Grid &grid,TurmiteState &t)
+        {
+            prepare(node,transitions,grid,t);
+            return run(transitions,grid,t);
+        }
+
+        // runs the node's turmite on from its current state, then searches the subtree below it
+        void explore(Node &node,TransitionTable &transitions,Grid &grid,TurmiteState &t,
+            ChunkResult &result,int &max_its,int &max_nonzero)
+        {
+            RunOutcome outcome = run(transitions,grid,t);
+            if(outcome==UNDEFINED_TRANSITION)
+            {
+                const int iSlot = t.slot;
+                const size_t mark = grid.mark();
+                const TurmiteState saved = t;
+                result.tried += n_ruled_out_at(node,iSlot);
+                for(size_t iChoice=0;iChoice<choices[iSlot].size();iChoice++)
+                {
+                    const Choice &choice = choices[iSlot][iChoice];
+                    define(node,iSlot,choice);
+                    if(n_passing_below(node)==0)
+                        result.tried += n_below(node,-1); // no need to run it
+                    else
+                    {
+                        transitions.update(iSlot,&node.turmite[0]);
+                        explore(node,transitions,grid,t,result,max_its,max_nonzero);
+                        grid.rollback(mark);
+                        t = saved;
+                    }
+                    undefine(node,iSlot,choice);
+                }
+                transitions.undefine(iSlot);
+                return;
+            }
+            // the outcome is the same for every way of completing the turmite
+            const unsigned long long n_passing = n_passing_below(node);
+            result.tried += n_below(node,-1);
+            result.tested += n_passing;
+            result.stats.count(outcome,t.its,n_passing);
+            if(outcome!=HALTED)
+                result.count_rejected(outcome,n_passing);
+            if(outcome==HALTED && n_passing>0 && (t.its>max_its || t.n_nonzero>max_nonzero))
+            {
+                max_its = std::max(t.its,max_its);
+                max_nonzero = std::max(t.n_nonzero,max_nonzero);
+                FoundRecord record;
+                record.its = t.its;
+                record.n_nonzero = t.n_nonzero;
+                record.turmite = node.turmite;
+                // report the unused transitions with their first non-halting choice
+                for(size_t iSlot=0;iSlot<node.defined.size();iSlot++)
+                {
+                    if(node.defined[iSlot])
+                        continue;
+                    for(size_t iChoice=0;iChoice<choices[iSlot].size();iChoice++)
+                    {
+                        if(!choices[iSlot][iChoice].halts)
+                        {
+                            for(int i=0;i<3;i++)
+                                record.turmite[iSlot*3+i] = choices[iSlot][iChoice].digits[i];
+                            break;
+                        }
+                    }
+                }
+                if(on_record)
+                    on_record(grid,record);
+                result.records.push_back(record);
+            }
+        }
+
+        // the number of complete turmites below a node, ignoring the given slot
+        unsigned long long n_below(const Node &node,int except_slot) const
+        {
+            unsigned long long n=1;
+            for(size_t iSlot=0;iSlot<node.defined.size();iSlot++)
+                if(!node.defined[iSlot] && (int)iSlot!=except_slot)
+                    n *= n_combinations[iSlot];
+            return n;
+        }
+
+        // the number of turmites below a node that the filter rules out by their choice for iSlot
+        unsigned long long n_ruled_out_at(const Node &node,int iSlot) const
+        {
+            return (n_combinations[iSlot]-choices[iSlot].size()) * n_below(node,iSlot);
+        }
+
+        // the number of turmites below a node that pass the filter: if one of the node's transitions
+        // halts then none of the remaining transitions may, otherwise exactly one of them must
+        unsigned long long n_passing_below(const Node &node) const
+        {
+            if(node.n_halts>1)
+                return 0;
+            unsigned long long no_halts=1,one_halt=0;
+            for(size_t iSlot=0;iSlot<node.defined.size();iSlot++)
+            {
+                if(node.defined[iSlot])
+                    continue;
+                one_halt = one_halt*n_nonhalting[iSlot] + (can_halt[iSlot] ? no_halts : 0);
+                no_halts *= n_nonhalting[iSlot];
+            }
+            return node.n_halts==1 ? no_halts : one_halt;
+        }
+
+        const std::vector<std::vector<unsigned char> >& possible_entries;
+        const int n_colors; // (for the transition tables)
+        StartFunction start;
+        RunFunction run;
+        RecordFunction on_record;
+
+        std::vector<std::vector<Choice> > choices; // the allowed values of each transition
+        std::vector<unsigned long long> n_combinations; // the number of values of each transition
+        std::vector<unsigned long long> n_nonhalting;
+        std::vector<bool> can_halt;
+
+        std::vector<Node> frontier; // the subtrees still to be searched, in depth-first order
+};
+
+typedef BasicTreeSearch<JournalGrid> TreeSearch;
+
+#endif
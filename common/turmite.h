@@ -0,0 +1,37 @@
+// The state of a running turmite, apart from the grid it is running on.
+
+#ifndef TURMITE_H
+#define TURMITE_H
+
+// STL:
+#include <vector>
+
+// local:
+#include "cycle_detection.h"
+#include "translation_detection.h"
+
+// why a turmite stopped running
+enum RunOutcome
+{
+    HALTED,
+    OFF_GRID, // moved off the grid: we say it moved too fast, not interesting
+    CYCLED, // returned to an earlier configuration (or one shifted along), so will never halt
+    TIMED_OUT, // still running after ITS steps
+    UNDEFINED_TRANSITION // needs a transition that hasn't been chosen yet (see tree_search.h)
+};
+
+struct TurmiteState
+{
+    std::vector<int> pos;
+    int dir; // the direction of the last move (relative turmites only)
+    int state;
+    int its; // the number of steps taken, including the halt step
+    int n_nonzero; // the number of cells with a color other than 0
+    int slot; // state*N_COLORS+color of the missing transition, after UNDEFINED_TRANSITION
+    int max_slot; // the highest state*N_COLORS+color read so far, -1 if none (the run so far doesn't depend on any higher slot)
+    unsigned long long hash; // of the cell colors
+    CycleDetector cycle;
+    TranslationDetector translation;
+};
+
+#endif
@@ -0,0 +1,473 @@
+// The inner loop of the search: running one turmite on a grid.
+//
+// The grid topology, the movement policy and the numbers of states and colors are template
+// parameters, so that each kind of search gets its own copy of the loop with the table sizes and
+// direction arithmetic known at compile time. The grid radius R and the step limit ITS are given
+// at run time. For numbers of states and colors that have no copy of their own, the generic kernel
+// takes them at run time instead (template arguments RUNTIME).
+//
+// The grid is either dense, a square (cube, ...) of side 2R+1 with the turmite starting in the
+// middle, or TILED: allocated a tile at a time as the turmite reaches it (see journal_grid.h), so
+// that there is no radius to stay within. A tiled grid is numbered as a very large square, with the
+// turmite starting in the middle, and a cell's tile is found from the high bits of its coordinates.
+// Only a memory budget (and without one, the most cells that a tiled grid lets a turmite reach)
+// limits how far the turmite can go.
+//
+// A dense grid has a border one cell wide all round it, painted with the color N_COLORS, which the
+// transition table maps to OFF_GRID (see transition_table.h). So the turmite's moves aren't
+// checked: it can step onto the border, and the next step's lookup stops it there. On a dense grid
+// the turmite is kept as the index of its cell rather than as coordinates, and a step adds an
+// offset from a table made when the engine is, which for relative turmites also holds the new
+// direction after each turn. The coordinates are only followed on the steps that the translation
+// detector looks at (see translation_detection.h), and worked out again from the index after the
+// steps that it skips.
+
+#ifndef TURMITE_ENGINE_H
+#define TURMITE_ENGINE_H
+
+// stdlib:
+#include <stdlib.h>
+
+// STL:
+#include <algorithm>
+
+// local:
+#include "cycle_detection.h"
+#include "grid_topology.h"
+#include "journal_grid.h"
+#include "transition_table.h"
+#include "translation_detection.h"
+#include "turmite.h"
+
+// a number of states or colors that is only known at run time
+const int RUNTIME = 0;
+
+// the number of cells in a dense grid of the given side, or 0 if they can't be numbered with an int
+inline unsigned int dense_cells(int SIDE,int N_DIM)
+{
+    unsigned long long n_cells=1;
+    for(int iDim=0;iDim<N_DIM;iDim++)
+    {
+        n_cells *= SIDE;
+        if(n_cells>0x7fffffff)
+            return 0;
+    }
+    return (unsigned int)n_cells;
+}
+
+// The grid that the engines run on. Packed cells (see journal_grid.h) cost a few instructions on
+// every step, which is only won back when the grid is too big for the faster caches, so they are
+// used from 3D up. (They hold one value more than the colors, for the border.)
+template<int N_DIM,int N_COLORS>
+struct EngineGrid
+{
+    typedef BasicJournalGrid<N_DIM>=3 ? CellBits<N_COLORS==RUNTIME ? RUNTIME : N_COLORS+1>::value : 8> type;
+};
+
+template<class Topology,class Movement,int N_STATES_,int N_COLORS_,bool TILED=false>
+class TurmiteEngine
+{
+    static_assert(MovementSupported<Topology,Movement>::value,
+        "this kind of movement isn't supported on this grid (see grid_topology.h)");
+    static_assert(Topology::N_DIM<=TranslationDetector::MAX_DIMS && Topology::N_DIRS<=TranslationDetector::MAX_DIRS,
+        "too many dimensions for the translation detector");
+
+    public:
+
+        static const int N_DIM = Topology::N_DIM;
+        static const int N_MOVES = 1+Topology::N_DIRS; // 0=halt, then a direction or a turn
+
+        typedef typename EngineGrid<N_DIM,N_COLORS_>::type Grid;
+
+        // tiles have side 1<<TILE_BITS, and each tile coordinate has KEY_BITS of the tile's key
+        static const int TILE_BITS = N_DIM==1 ? 8 : N_DIM==2 ? 4 : N_DIM==3 ? 3 : 2;
+        static const int KEY_BITS = N_DIM==1 ? 32 : 64/N_DIM;
+        static const int TILED_SIDE = (1 << (KEY_BITS+TILE_BITS<30 ? KEY_BITS+TILE_BITS : 30)) - 1; // (odd, so there is a middle)
+
+        // R: the radius of the grid (not used if TILED), ITS: the number of steps after which we give
+        // up, max_bytes: the memory budget of a TILED grid (0 for none), translation: look for turmites
+        // that repeat a configuration shifted along (see translation_detection.h). n_states and
+        // n_colors must match the template arguments, unless those are RUNTIME.
+        TurmiteEngine(int R,int ITS,int n_states,int n_colors,unsigned long long max_bytes=0,bool translation=true)
+            : R(R),ITS(ITS),SIDE(TILED ? TILED_SIDE : 2*R+3),START(TILED ? TILED_SIDE/2 : R+1),
+            N_CELLS(TILED ? 0 : dense_cells(SIDE,N_DIM)),MAX_CELLS(max_bytes*CELLS_PER_BYTE),
+            n_states_(n_states),n_colors_(n_colors),translation(translation),zobrist(n_colors)
+        {
+            if(!TILED)
+                make_steps();
+        }
+
+        // the number of cells of a dense grid, with its border (0 if too many to number), or 0 if TILED
+        unsigned int n_cells() const { return N_CELLS; }
+        int side() const { return SIDE; }
+        int n_states() const { return N_STATES_!=RUNTIME ? N_STATES_ : n_states_; }
+        int n_colors() const { return N_COLORS_!=RUNTIME ? N_COLORS_ : n_colors_; }
+
+        // whether a turmite on a TILED grid can run out of memory before it has taken ITS steps (in
+        // which it reaches at most ITS+1 tiles)
+        bool memory_limited() const
+        {
+            const unsigned long long reach = ((unsigned long long)ITS+1)*TILE_CELLS;
+            return TILED && (reach>Grid::MAX_TILED_CELLS || (MAX_CELLS && reach>MAX_CELLS));
+        }
+
+        // make a grid ready for this engine (throws std::bad_alloc if a dense grid is too large)
+        void prepare_grid(Grid &grid) const
+        {
+            if(TILED)
+            {
+                grid.use_tiles(1u<<(TILE_BITS*N_DIM),MAX_CELLS);
+                return;
+            }
+            grid.resize(N_CELLS);
+            // paint the border, every cell that isn't on the grid of side 2R+1 inside it
+            int pos[N_DIM];
+            for(unsigned int iCell=0;iCell<N_CELLS;iCell++)
+            {
+                cell_position(iCell,pos);
+                for(int iDim=0;iDim<N_DIM;iDim++)
+                    pos[iDim]--;
+                if(!Topology::contains(pos,2*R+1))
+                    grid.fix(iCell,(unsigned char)n_colors());
+            }
+        }
+
+        // On a dense grid: the index of the start cell, and what a move does from a cell of the given
+        // parity facing the given way (as in steps, below), for engines that keep their own grids
+        // (see batch_engine.h).
+        int start_cell() const
+        {
+            int pos[N_DIM];
+            std::fill(pos,pos+N_DIM,START);
+            return cell_index(pos);
+        }
+        void dense_step(int parity,int facing,int move,int &offset,int &dir) const
+        {
+            const Step &step = steps[Topology::STEP_PARITY ? parity : 0][Movement::RELATIVE ? facing : 0][move];
+            offset = step.offset;
+            dir = step.dir;
+        }
+
+        // put a turmite in the middle of the grid (the caller clears the grid)
+        void start(TurmiteState &t) const
+        {
+            t.pos.assign(N_DIM,START); // start in the middle
+            t.state = 0; // start in state 0 (symmetry constraint)
+            t.dir = Movement::START_DIR;
+            t.its = 0;
+            t.n_nonzero = 0;
+            t.max_slot = -1;
+            t.hash = 0; // the grid is empty
+            t.cycle.reset();
+            t.translation.reset();
+        }
+
+        // Run a turmite on the given grid until it halts, moves off the grid, repeats a configuration
+        // (or one shifted along), has taken ITS steps or needs a transition that hasn't been chosen
+        // yet. (The step that takes it off the grid isn't counted.)
+        RunOutcome run(const TransitionTable &transitions,Grid &grid,TurmiteState &t) const
+        {
+            const int SIDE=this->SIDE,ITS=this->ITS,N_COLORS=n_colors(); // (so the compiler can keep them in registers)
+            const bool translation=this->translation;
+            int ts=t.state,t_pos[N_DIM],t_dir=t.dir,its,n_nonzero=t.n_nonzero,max_slot=t.max_slot,iDim,iCell,iSlot,new_dir;
+            // the steps that the translation detector skips (on a dense grid, t_pos isn't followed through them)
+            int room = t.translation.following() ? 0 : std::max(TranslationDetector::FOLLOW_AFTER-t.its,0);
+            bool skipped = room>0;
+            unsigned char color,new_color,move;
+            TransitionTable::Transition transition;
+            unsigned long long hash=t.hash;
+            unsigned long long key,tile_key=~0ULL; // (for TILED: the tile the turmite was last on)
+            unsigned int tile_first=0;
+            RunOutcome outcome=TIMED_OUT;
+            auto color_at = [&](const int *pos) { return cell_color(grid,pos); };
+            auto position = [&](unsigned int iCell,int *pos) { cell_position(grid,iCell,pos); };
+            for(iDim=0;iDim<N_DIM;iDim++) t_pos[iDim] = t.pos[iDim];
+            if(!TILED)
+                iCell = cell_index(t_pos);
+            for(its=t.its;its<ITS;its++)
+            {
+                if(TILED)
+                {
+                    // the tile's key is its coordinates, the cell is at an offset from its first cell
+                    key = (unsigned long long)(t_pos[0]>>TILE_BITS);
+                    iCell = t_pos[0] & TILE_MASK;
+                    for(iDim=1;iDim<N_DIM;iDim++)
+                    {
+                        key = key<<KEY_BITS | (unsigned long long)(t_pos[iDim]>>TILE_BITS);
+                        iCell = iCell<<TILE_BITS | (t_pos[iDim] & TILE_MASK);
+                    }
+                    if(key!=tile_key)
+                    {
+                        tile_first = grid.tile(key);
+                        if(tile_first==Grid::NO_TILE)
+                        {
+                            // over the memory budget: we treat it as having moved off the grid
+                            outcome = OFF_GRID;
+                            break;
+                        }
+                        tile_key = key;
+                    }
+                    iCell += tile_first;
+                }
+                color = grid[iCell];
+                iSlot = ts*N_COLORS+color;
+                transition = transitions[iSlot+ts]; // the only lookup of the turmite's rules
+                if(transition>=TransitionTable::OFF_GRID)
+                {
+                    if(transition==TransitionTable::OFF_GRID)
+                    {
+                        // on the border: the last step took the turmite off the grid
+                        outcome = OFF_GRID;
+                        its--;
+                    }
+                    else
+                    {
+                        t.slot = iSlot;
+                        outcome = UNDEFINED_TRANSITION;
+                    }
+                    break;
+                }
+                if(t.cycle.repeated(its,hash,iCell,ts,t_dir,grid))
+                {
+                    outcome = CYCLED;
+                    break;
+                }
+                if(translation && --room<0)
+                {
+                    if(!TILED && skipped)
+                        cell_position(iCell,t_pos);
+                    if(!t.translation.following())
+                        follow(grid,t_pos,t.translation);
+                    if(t.translation.repeated<Topology>(its,t_pos,ts,t_dir,grid,color_at,position))
+                    {
+                        outcome = CYCLED;
+                        break;
+                    }
+                    room = t.translation.room<N_DIM>(t_pos);
+                    skipped = room>0;
+                }
+                max_slot = iSlot>max_slot ? iSlot : max_slot;
+                move = TransitionTable::move(transition);
+                new_color = TransitionTable::color(transition);
+                if(color!=new_color)
+                {
+                    grid.change(iCell,color,new_color); // cell changes color
+                    hash ^= zobrist(iCell,color) ^ zobrist(iCell,new_color);
+                    if(color==0) n_nonzero++;
+                    else if(new_color==0) n_nonzero--;
+                }
+                if(move==0) // halted
+                {
+                    outcome = HALTED;
+                    its++; // want the number of steps to include the halt step
+                    break;
+                }
+                if(!TILED)
+                {
+                    // (the border stops the turmite if this takes it off the grid)
+                    const Step &step = steps[Topology::STEP_PARITY ? iCell&1 : 0][Movement::RELATIVE ? t_dir : 0][move];
+                    iCell += step.offset;
+                    new_dir = step.dir;
+                    if(translation && room==0) // (the next step is looked at)
+                        for(iDim=0;iDim<N_DIM;iDim++) t_pos[iDim] += step.delta[iDim];
+                }
+                else
+                {
+                    new_dir = Movement::template direction<Topology>(t_dir,move);
+                    if(!Topology::move(t_pos,new_dir,SIDE))
+                    {
+                        // turmite has moved off the grid
+                        // we say it moved too fast: not interesting
+                        outcome = OFF_GRID;
+                        break;
+                    }
+                }
+                ts = TransitionTable::state(transition); // turmite adopts new state
+                if(Movement::RELATIVE)
+                    t_dir = new_dir; // turmite adopts new orientation
+            }
+            if(!TILED)
+            {
+                if(outcome==TIMED_OUT && grid[iCell]==N_COLORS)
+                {
+                    // the last step was onto the border
+                    outcome = OFF_GRID;
+                    its--;
+                }
+                cell_position(iCell,t_pos);
+            }
+            for(iDim=0;iDim<N_DIM;iDim++) t.pos[iDim] = t_pos[iDim];
+            t.state = ts;
+            t.dir = t_dir;
+            t.its = its;
+            t.n_nonzero = n_nonzero;
+            t.max_slot = max_slot;
+            t.hash = hash;
+            return outcome;
+        }
+
+        // Calls f(pos,color) for every cell that isn't color 0, with pos its coordinates relative to
+        // the start. Only the cells written since the grid was cleared are looked at, so the cost is
+        // proportional to the steps taken rather than to the size of the grid (a cell can come more
+        // than once).
+        template<class F>
+        void for_each_cell(const Grid &grid,F f) const
+        {
+            int pos[N_DIM],iDim;
+            grid.for_each_write([&](unsigned int iCell)
+            {
+                const unsigned char color = grid[iCell];
+                if(color==0)
+                    return;
+                cell_position(grid,iCell,pos);
+                for(iDim=0;iDim<N_DIM;iDim++)
+                    pos[iDim] -= START;
+                f(pos,color);
+            });
+        }
+
+        // the bounding box of the cells that aren't color 0, as the lowest (lo) and highest (hi)
+        // coordinate along each axis relative to the start, or all 0 if there are none
+        void bounds(const Grid &grid,int *lo,int *hi) const
+        {
+            bool any=false;
+            std::fill(lo,lo+N_DIM,0);
+            std::fill(hi,hi+N_DIM,0);
+            for_each_cell(grid,[&](const int *pos,unsigned char)
+            {
+                for(int iDim=0;iDim<N_DIM;iDim++)
+                {
+                    lo[iDim] = any ? std::min(lo[iDim],pos[iDim]) : pos[iDim];
+                    hi[iDim] = any ? std::max(hi[iDim],pos[iDim]) : pos[iDim];
+                }
+                any = true;
+            });
+        }
+
+    private:
+
+        // start the translation detector on a turmite at pos that has been running for a while
+        void follow(const Grid &grid,const int *pos,TranslationDetector &translation) const
+        {
+            int origin[N_DIM],lo[N_DIM],hi[N_DIM];
+            bounds(grid,lo,hi);
+            for(int iDim=0;iDim<N_DIM;iDim++)
+            {
+                origin[iDim] = START;
+                lo[iDim] = std::min(lo[iDim]+START,pos[iDim]);
+                hi[iDim] = std::max(hi[iDim]+START,pos[iDim]);
+            }
+            translation.follow<N_DIM>(origin,lo,hi,pos);
+        }
+
+        static const int TILE_MASK = (1<<TILE_BITS)-1;
+        static const int CELLS_PER_BYTE = 8/Grid::CELL_BITS;
+        static const unsigned int TILE_CELLS = 1u<<(TILE_BITS*N_DIM);
+
+        // on a dense grid: what a move does, by the parity of the cell's index (only if the topology
+        // needs it: the side is odd, so that is the parity of x+y+...), the direction the turmite is
+        // facing (relative turmites only) and the move
+        static const int N_PARITIES = Topology::STEP_PARITY ? 2 : 1;
+        static const int N_FACINGS = Movement::RELATIVE ? N_MOVES : 1;
+        struct Step
+        {
+            int offset; // added to the cell's index
+            int dir; // the new direction
+            int delta[N_DIM]; // added to the coordinates (only followed for the translation detector)
+        };
+        Step steps[N_PARITIES][N_FACINGS][N_MOVES];
+
+        void make_steps()
+        {
+            int pos[N_DIM],next[N_DIM];
+            for(int parity=0;parity<N_PARITIES;parity++)
+            {
+                for(int facing=0;facing<N_FACINGS;facing++)
+                {
+                    for(int move=0;move<N_MOVES;move++)
+                    {
+                        // from the start cell, whose x+y is even, or the one after it
+                        std::fill(pos,pos+N_DIM,START);
+                        pos[N_DIM-1] += parity;
+                        std::copy(pos,pos+N_DIM,next);
+                        const int dir = Movement::template direction<Topology>(Movement::RELATIVE ? facing : Movement::START_DIR,move);
+                        if(move>0 && dir>0) // (not a halt, or a facing that can't happen)
+                            Topology::step(next,dir);
+                        Step &step = steps[parity][facing][move];
+                        step.offset = cell_index(next)-cell_index(pos);
+                        step.dir = dir;
+                        for(int iDim=0;iDim<N_DIM;iDim++)
+                            step.delta[iDim] = next[iDim]-pos[iDim];
+                    }
+                }
+            }
+        }
+
+        // the index of the cell of a dense grid at pos, and back
+        int cell_index(const int *pos) const
+        {
+            int iCell = pos[0];
+            for(int iDim=1;iDim<N_DIM;iDim++) iCell = iCell*SIDE + pos[iDim];
+            return iCell;
+        }
+        void cell_position(unsigned int iCell,int *pos) const
+        {
+            for(int iDim=N_DIM-1;iDim>=0;iDim--)
+            {
+                pos[iDim] = (int)(iCell%SIDE);
+                iCell /= SIDE;
+            }
+        }
+
+        // the coordinates of a cell of a tile, from the tile's key and the cell's offset within it
+        static void cell_position(unsigned long long key,unsigned int offset,int *pos)
+        {
+            for(int iDim=N_DIM-1;iDim>=0;iDim--)
+            {
+                pos[iDim] = (int)(key & ((1ULL<<KEY_BITS)-1))<<TILE_BITS | (offset & TILE_MASK);
+                key >>= KEY_BITS;
+                offset >>= TILE_BITS;
+            }
+        }
+
+        // the coordinates of a cell of either kind of grid
+        void cell_position(const Grid &grid,unsigned int iCell,int *pos) const
+        {
+            if(TILED)
+                cell_position(grid.tile_key(iCell),iCell%TILE_CELLS,pos); // (tiles start at a multiple of TILE_CELLS)
+            else
+                cell_position(iCell,pos);
+        }
+
+        // the color of the cell at pos for the translation detector, which takes the cells off the
+        // grid (the border, and tiles that haven't been allocated) as color 0
+        unsigned char cell_color(const Grid &grid,const int *pos) const
+        {
+            for(int iDim=0;iDim<N_DIM;iDim++)
+                if(pos[iDim]<0 || pos[iDim]>=SIDE)
+                    return 0;
+            if(!TILED)
+            {
+                const unsigned char color = grid[cell_index(pos)];
+                return color==n_colors() ? 0 : color;
+            }
+            unsigned long long key = (unsigned long long)(pos[0]>>TILE_BITS);
+            unsigned int offset = pos[0] & TILE_MASK;
+            for(int iDim=1;iDim<N_DIM;iDim++)
+            {
+                key = key<<KEY_BITS | (unsigned long long)(pos[iDim]>>TILE_BITS);
+                offset = offset<<TILE_BITS | (pos[iDim] & TILE_MASK);
+            }
+            const unsigned int first_cell = grid.find_tile(key);
+            return first_cell==Grid::NO_TILE ? 0 : grid[first_cell+offset];
+        }
+
+        const int R,ITS,SIDE,START;
+        const unsigned int N_CELLS;
+        const unsigned long long MAX_CELLS;
+        const int n_states_,n_colors_; // (only used by the generic kernel)
+        const bool translation; // look for turmites that repeat a configuration shifted along
+        const ZobristKeys zobrist; // for hashing the cell colors (see cycle_detection.h)
+};
+
+#endif
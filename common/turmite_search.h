@@ -0,0 +1,1120 @@
+// The search for terminating turmites, shared by the square, hex and tri front ends.
+//
+// A front end chooses the grid, the possible values of each entry of the transition table (which
+// is where the symmetries of each grid are used to cut down the search) and any rules about single
+// transitions. The movement and the numbers of states and colors come from the command line, and
+// search_grid() picks the kernel compiled for them (see turmite_engine.h). Everything else - the
+// odometer or tree enumeration, the worker threads, records, checkpoints and shards - is the same
+// for every grid.
+
+#ifndef TURMITE_SEARCH_H
+#define TURMITE_SEARCH_H
+
+// stdlib:
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// STL:
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// local:
+#include "batch_engine.h"
+#include "checkpoint.h"
+#include "journal_grid.h"
+#include "macro_engine.h"
+#include "outcome_memo.h"
+#include "outcome_store.h"
+#include "parallel_search.h"
+#include "reachability.h"
+#include "record_images.h"
+#include "results_writer.h"
+#include "search_options.h"
+#include "search_stats.h"
+#include "symmetry.h"
+#include "transition_table.h"
+#include "tree_search.h"
+#include "turmite.h"
+#include "turmite_engine.h"
+
+struct SearchSettings
+{
+    unsigned long long PRINT_EVERY; // how often to report back
+    int CHECKPOINT_EVERY; // how often to save the position of the search, in seconds
+    int STATS_EVERY; // with --stats, how often to save a snapshot of the counts, in seconds
+    int MACRO_AFTER; // the odometer runs turmites still going after this many steps again with macro-steps
+    size_t MEMO_ENTRIES; // the most outcomes that each of the odometer's threads remembers (see outcome_memo.h)
+    unsigned long long HELD_OUT_CHUNK; // with --stages, the stages after the first run this many machines in each chunk
+
+    // if not empty, the odometer starts just after this machine: the color, move and state of each
+    // transition, in the order they appear in the results file
+    std::vector<unsigned char> first_turmite;
+
+    // if set, called with the cells of each new record when it halted, e.g. to save a picture of it
+    // (on a thread of its own, see record_images.h)
+    RenderQueue::DrawFunction draw_record;
+
+    SearchSettings() : PRINT_EVERY(10000),CHECKPOINT_EVERY(60),STATS_EVERY(10),MACRO_AFTER(1<<16),MEMO_ENTRIES(1<<20),HELD_OUT_CHUNK(1<<12) {}
+};
+
+// The possible values of each entry of the transition table: possible_entries[(state*N_COLORS+color)*3+i]
+// lists the colors to write (i=0), the moves (i=1) and the next states (i=2). A front end can remove
+// values that are equivalent by symmetry.
+inline std::vector<std::vector<unsigned char> > make_possible_entries(int N_STATES,int N_COLORS,int N_MOVES)
+{
+    std::vector<std::vector<unsigned char> > possible_entries(N_STATES*N_COLORS*3);
+    for(int iState=0;iState<N_STATES;iState++)
+    {
+        for(int iColor=0;iColor<N_COLORS;iColor++)
+        {
+            const int iEntry = (iState*N_COLORS+iColor)*3;
+            for(int i=0;i<N_COLORS;i++)
+                possible_entries[iEntry+0].push_back(i);
+            // no halt state for states >2 (by symmetry)
+            for(int i=(iState<=2 ? 0 : 1);i<N_MOVES;i++)
+                possible_entries[iEntry+1].push_back(i);
+            for(int i=0;i<N_STATES;i++)
+                possible_entries[iEntry+2].push_back(i);
+        }
+    }
+    return possible_entries;
+}
+
+// Runs the search and writes the records to found_*.txt (and with --log-halted, the halting machines
+// to found_*.jsonl, one JSON object per line, and with --stats, snapshots of the counts of
+// search_stats.h to found_*.stats.jsonl, and with --stages, the machines left undecided by each
+// stage to found_*.held_out<stage>.txt and by the last to found_*.undecided.txt). allowed() can rule
+// out single transitions.
+// N_STATES_ and N_COLORS_ are options.n_states and options.n_colors, or RUNTIME for the generic kernel.
+// TILED is options.unbounded.
+template<class Topology,class Movement,int N_STATES_,int N_COLORS_,bool TILED>
+int search_turmites(const SearchSettings &settings,const SearchOptions &options,
+    const std::vector<std::vector<unsigned char> > &possible_entries,TreeSearch::TransitionFilter allowed)
+{
+    using namespace std;
+
+    typedef TurmiteEngine<Topology,Movement,N_STATES_,N_COLORS_,TILED> Engine;
+    typedef BatchEngine<Topology,Movement,N_STATES_,N_COLORS_> Batch;
+    typedef MacroEngine<Topology,Movement,N_STATES_,N_COLORS_> Macro;
+    typedef typename Engine::Grid Grid;
+    const Engine engine(options.R,options.ITS,options.n_states,options.n_colors,(unsigned long long)options.memory_mb<<20,options.translation);
+    const int N_DIM = Engine::N_DIM;
+    const int N_STATES = engine.n_states();
+    const int N_COLORS = engine.n_colors();
+    const int N_SLOTS = N_STATES*N_COLORS;
+    const int ITS = options.ITS;
+    const int R = options.R;
+    const int n_threads = options.n_threads;
+
+    vector<Grid> grids; // one grid for each worker thread
+    vector<shared_ptr<Batch> > batches(n_threads); // for --batch, made by each worker thread when it starts
+    vector<shared_ptr<MacroGrid> > macro_grids(n_threads); // made by each worker thread when it first needs one
+    vector<shared_ptr<OutcomeMemo> > memos(n_threads); // for the odometer, made by each worker thread when it starts
+    const bool use_memo = options.memo && !options.tree;
+    OutcomeStore store; // with --reuse, the outcomes of an earlier search
+    const bool use_store = !options.reuse.empty();
+    vector<shared_ptr<OutcomeStore::Cursor> > store_cursors(n_threads); // made by each worker thread when it starts
+    try {
+        if(!TILED && (engine.n_cells()==0 || (options.batch && !Batch::fits(engine.n_cells()))))
+            throw bad_alloc();
+        Grid grid;
+        engine.prepare_grid(grid);
+        grids.resize(n_threads,grid);
+    }
+    catch(...)
+    {
+        cout << "Grid too large to be allocated. Reduce the value of R, or use --unbounded." << endl;
+        exit(1);
+    }
+
+    // With --stages every machine is run with the cheapest budget first, and those that move off
+    // the grid or are still running are held out, to be run again with the next budget, and so on
+    // up to ITS and R.
+    vector<SearchBudget> budgets = options.stages;
+    budgets.push_back(SearchBudget{ITS,R});
+    const int n_stages = (int)budgets.size();
+    const bool staged = n_stages>1;
+    int stage=0; // counting from 0
+    vector<unsigned long long> stage_machines; // after the first stage: the machines held out by the one before
+
+    // The odometer runs each turmite for up to MACRO_AFTER steps, and any that are still going are
+    // run again from the start with macro-steps (dense grids only, see macro_engine.h). These are
+    // made again for the budget of each stage, as are the workers' grids, batches, macro grids and
+    // memos.
+    shared_ptr<const Macro> macro;
+    bool use_macro=false;
+    int FIRST_ITS=ITS; // the odometer's first run of each turmite
+    shared_ptr<const Engine> first_engine,stage_engine; // (stage_engine runs for the whole of the stage's budget)
+    auto begin_stage = [&](int new_stage)
+    {
+        stage = new_stage;
+        const SearchBudget &budget = budgets[stage];
+        const bool macro_wanted = options.macro && !TILED && !options.tree && budget.ITS>settings.MACRO_AFTER;
+        macro.reset(new Macro(macro_wanted ? budget.R : 0,budget.ITS,options.n_states,options.n_colors));
+        use_macro = macro_wanted && macro->usable();
+        FIRST_ITS = use_macro ? settings.MACRO_AFTER : budget.ITS;
+        first_engine.reset(new Engine(budget.R,FIRST_ITS,options.n_states,options.n_colors,(unsigned long long)options.memory_mb<<20,options.translation));
+        stage_engine.reset(new Engine(budget.R,budget.ITS,options.n_states,options.n_colors,(unsigned long long)options.memory_mb<<20,options.translation));
+        for(int iThread=0;iThread<n_threads;iThread++)
+        {
+            if(staged)
+                stage_engine->prepare_grid(grids[iThread]); // (the border is at the stage's radius)
+            batches[iThread].reset();
+            macro_grids[iThread].reset();
+            memos[iThread].reset();
+        }
+        if(use_macro)
+            cout << "Turmites still running after " << FIRST_ITS << " steps are run again with macro-steps." << endl;
+    };
+
+    int max_its=-1;
+    int max_nonzero=-1;
+
+    unsigned long long tried=0,tested=0;
+    unsigned long long n_unreachable=0; // passed the filters, but weren't tested because they can never halt
+    unsigned long long n_off_grid=0,n_cycled=0,n_timed_out=0; // why the tested machines that didn't halt were rejected
+
+    ostringstream oss;
+    oss << "found_" << Topology::name() << N_DIM << "d_";
+    if(Topology::SUPPORTS_ABSOLUTE)
+        oss << Movement::name(); // (tri turmites are always relative)
+    oss << N_STATES << "s_" << N_COLORS << "c";
+    // (turmites stopped as translated cycles would otherwise have other outcomes)
+    const string outcomes_header = outcome_store_header(oss.str()+(options.translation ? " translation" : ""),possible_entries,ITS,R);
+    if(options.n_shards>1)
+        oss << "_shard" << options.shard << "of" << options.n_shards;
+    const string found_filename = oss.str()+".txt";
+    const string log_filename = oss.str()+".jsonl";
+    const string stats_filename = oss.str()+".stats.jsonl";
+    const string outcomes_filename = oss.str()+".its"+to_string(ITS)+"_r"+to_string(R)+".outcomes";
+    // with --stages, the machines held out by a stage: one per line, its index, why it was held out
+    // and its table as in found_*.txt, e.g. "1234 timed_out {{{1,'E',1},{1,'W',0}},{{0,'W',0},{1,'',0}}}"
+    auto held_out_filename = [&](int of_stage) -> string
+        { return of_stage<n_stages-1 ? oss.str()+".held_out"+to_string(of_stage+1)+".txt" : oss.str()+".undecided.txt"; };
+    auto read_held_out = [&](int of_stage) -> bool
+    {
+        ifstream in(held_out_filename(of_stage).c_str());
+        unsigned long long machine;
+        string rest;
+        stage_machines.clear();
+        while(in >> machine && getline(in,rest))
+            stage_machines.push_back(machine);
+        return in.eof();
+    };
+    const bool log_halted = options.log_halted>=0;
+    // a checkpoint can only be resumed by the same search
+    ostringstream parameters;
+    parameters << found_filename << " ITS=" << ITS;
+    if(TILED)
+        parameters << " unbounded memory=" << options.memory_mb;
+    else
+        parameters << " R=" << R;
+    parameters << (options.tree ? " tree" : " odometer");
+    if(!options.tree && options.symmetry)
+        parameters << " symmetry";
+    if(!options.tree && options.prune)
+        parameters << " prune";
+    if(options.translation)
+        parameters << " translation";
+    if(log_halted)
+        parameters << " log_halted=" << options.log_halted;
+    if(options.save_outcomes)
+        parameters << " save_outcomes";
+    if(use_store)
+        parameters << " reuse=" << options.reuse;
+    if(staged)
+    {
+        parameters << " stages=";
+        for(int iStage=0;iStage<n_stages-1;iStage++)
+            parameters << (iStage>0 ? "," : "") << budgets[iStage].ITS << ":" << budgets[iStage].R;
+    }
+    const string checkpoint_filename = found_filename+".checkpoint";
+    Checkpoint checkpoint;
+    checkpoint.parameters = parameters.str();
+    checkpoint.chunking = n_threads;
+    checkpoint.next_chunk = 0;
+    checkpoint.stage = 0;
+    checkpoint.held_out_size = 0;
+    ResultsWriter out,log,stats_out,held_out,outcomes_out; // (written on threads of their own, see results_writer.h)
+    bool opened;
+    if(options.resume)
+    {
+        if(!load_checkpoint(checkpoint_filename,checkpoint))
+        {
+            cout << "Failed to read checkpoint: " << checkpoint_filename << endl;
+            exit(1);
+        }
+        if(checkpoint.parameters!=parameters.str())
+        {
+            cout << "The checkpoint is for a different search: " << checkpoint.parameters << endl;
+            exit(1);
+        }
+        // drop any records written after the checkpoint, they will be found again
+        if(!truncate_file(found_filename,checkpoint.found_size) || (log_halted && !truncate_file(log_filename,checkpoint.log_size))
+            || (staged && !truncate_file(held_out_filename(checkpoint.stage),checkpoint.held_out_size))
+            || (options.save_outcomes && !truncate_file(outcomes_filename,checkpoint.outcomes_size)))
+        {
+            cout << "Results file is shorter than when the checkpoint was saved: " << found_filename << endl;
+            exit(1);
+        }
+        if(checkpoint.stage>0 && !read_held_out(checkpoint.stage-1))
+        {
+            cout << "Failed to read the machines held out by stage " << checkpoint.stage << ": " << held_out_filename(checkpoint.stage-1) << endl;
+            exit(1);
+        }
+        opened = out.open(found_filename,true) && (!log_halted || log.open(log_filename,true))
+            && (!staged || held_out.open(held_out_filename(checkpoint.stage),true))
+            && (!options.save_outcomes || outcomes_out.open(outcomes_filename,true,true));
+        tried = checkpoint.tried;
+        tested = checkpoint.tested;
+        n_unreachable = checkpoint.n_unreachable;
+        n_off_grid = checkpoint.n_off_grid;
+        n_cycled = checkpoint.n_cycled;
+        n_timed_out = checkpoint.n_timed_out;
+        max_its = checkpoint.max_its;
+        max_nonzero = checkpoint.max_nonzero;
+        cout << "Resuming from checkpoint: " << checkpoint_filename << endl;
+    }
+    else
+    {
+        opened = out.open(found_filename,false) && (!log_halted || log.open(log_filename,false))
+            && (!staged || held_out.open(held_out_filename(0),false))
+            && (!options.save_outcomes || outcomes_out.open(outcomes_filename,false,true));
+        if(options.save_outcomes)
+            outcomes_out.write(outcomes_header);
+    }
+    if(options.stats)
+        opened = opened && stats_out.open(stats_filename,options.resume); // (the counts start again when resuming)
+    if(!opened)
+    {
+        cout << "Failed to open the results files: " << found_filename << endl;
+        exit(1);
+    }
+
+    cout << "Saving results to: " << found_filename << endl;
+    if(options.stats)
+        cout << "Saving counts of where the search's time goes to: " << stats_filename << endl;
+    if(log_halted)
+        cout << "Logging the turmites that halt after " << options.log_halted << " or more steps to: " << log_filename << endl;
+    if(options.save_outcomes)
+        cout << "Saving the outcome of every turmite tested to: " << outcomes_filename << endl;
+    if(use_store)
+    {
+        // the file must number the machines as we do
+        if(!store.open(options.reuse))
+        {
+            cout << "Failed to read the outcomes file: " << options.reuse << endl;
+            exit(1);
+        }
+        if(store.search()!=outcomes_header.substr(0,outcomes_header.rfind(" ITS=")))
+        {
+            cout << "The outcomes file is for a different search: " << store.search() << endl;
+            exit(1);
+        }
+        cout << "Taking the outcomes that are known with these limits from: " << options.reuse << " (ITS=" << store.its() << " R=" << store.radius() << ")" << endl;
+        if(store.radius()>R)
+            cout << "(None are, since its radius is larger.)" << endl;
+    }
+
+    // compute how far we've got to go
+    unsigned long long target=1;
+    for(int iEntry=0;iEntry<3*N_SLOTS;iEntry++)
+        target *= possible_entries[iEntry].size();
+    cout << "Total number of machines: " << target << endl;
+
+    // the odometer starts just after the given machine, if there is one
+    unsigned long long first_machine = 0;
+    if(!settings.first_turmite.empty())
+    {
+        vector<unsigned char> turmite(N_SLOTS*3);
+        for(int iEntry=0;iEntry<3*N_SLOTS;iEntry++)
+            turmite[iEntry] = find(possible_entries[iEntry].begin(),possible_entries[iEntry].end(),
+                settings.first_turmite[iEntry]) - possible_entries[iEntry].begin();
+        first_machine = turmite_to_index(&turmite[0],possible_entries)+1; // the initial turmite is not tested
+    }
+
+    // the odometer's version of allowed(): for each slot, whether each combination of its digits is allowed
+    vector<vector<bool> > slot_allowed(N_SLOTS);
+    for(int iSlot=0;iSlot<N_SLOTS;iSlot++)
+    {
+        const vector<unsigned char> &colors = possible_entries[iSlot*3+0];
+        const vector<unsigned char> &moves = possible_entries[iSlot*3+1];
+        const vector<unsigned char> &states = possible_entries[iSlot*3+2];
+        for(size_t iState=0;iState<states.size();iState++)
+            for(size_t iMove=0;iMove<moves.size();iMove++)
+                for(size_t iColor=0;iColor<colors.size();iColor++)
+                    slot_allowed[iSlot].push_back(allowed(iSlot,colors[iColor],moves[iMove],states[iState]));
+    }
+
+    // the odometer skips machines that are copies of earlier ones up to symmetry (a memory budget
+    // isn't quite symmetric, so if a turmite can reach it only the states and colors are renumbered)
+    MoveSymmetries move_symmetries = Topology::move_symmetries(Movement::RELATIVE);
+    if(engine.memory_limited())
+        move_symmetries.resize(1);
+    const SymmetryFilter symmetry(possible_entries,N_STATES,N_COLORS,move_symmetries,allowed);
+    // (not when starting after a given machine: a machine's family is then lost if the first of it
+    // comes before that one)
+    const bool use_symmetry = !options.tree && options.symmetry && symmetry.size()>0 && settings.first_turmite.empty();
+    if(use_symmetry)
+        cout << "Skipping machines that are copies of earlier ones under " << symmetry.size() << " symmetries." << endl;
+    // and machines that can never get to their halt
+    const bool use_reachability = !options.tree && options.prune;
+    if(use_reachability)
+        cout << "Skipping machines that can't reach their halt from the start." << endl;
+
+    begin_stage(checkpoint.stage);
+
+    // runs a turmite that was still going after FIRST_ITS steps again, with macro-steps
+    auto run_long = [&](int iThread,const TransitionTable &transitions,TurmiteState &t) -> RunOutcome
+    {
+        if(!macro_grids[iThread])
+        {
+            macro_grids[iThread].reset(new MacroGrid);
+            macro->prepare_grid(*macro_grids[iThread]);
+        }
+        macro_grids[iThread]->clear();
+        macro->start(t);
+        return macro->run(transitions,*macro_grids[iThread],t);
+    };
+
+    auto start_turmite = [&](TurmiteState &t) { engine.start(t); };
+    auto run_turmite = [&](const TransitionTable &transitions,Grid &grid,TurmiteState &t)
+        { return engine.run(transitions,grid,t); };
+
+    // With pictures, the worker that finds a record copies the cells in its bounding box from the
+    // grid it halted on, so the commits never run a record again. Chunk records that can't beat the
+    // records committed so far aren't copied.
+    atomic<int> committed_its(max_its),committed_nonzero(max_nonzero);
+    auto wants_snapshot = [&](int its,int n_nonzero)
+        { return settings.draw_record && (its>committed_its || n_nonzero>committed_nonzero); };
+    auto take_snapshot = [&](const Engine &on,const Grid &grid,FoundRecord &record)
+    {
+        record.bounds.resize(2*N_DIM);
+        on.bounds(grid,&record.bounds[0],&record.bounds[N_DIM]);
+        size_t n_cells=1;
+        for(int iDim=0;iDim<N_DIM;iDim++)
+            n_cells *= record.bounds[N_DIM+iDim]-record.bounds[iDim]+1;
+        record.cells.assign(n_cells,0);
+        on.for_each_cell(grid,[&](const int *pos,unsigned char color)
+        {
+            size_t iCell=0;
+            for(int iDim=0;iDim<N_DIM;iDim++)
+                iCell = iCell*(record.bounds[N_DIM+iDim]-record.bounds[iDim]+1) + pos[iDim]-record.bounds[iDim];
+            record.cells[iCell] = color;
+        });
+    };
+    auto tree_record = [&](const Grid &grid,FoundRecord &record)
+    {
+        if(wants_snapshot(record.its,record.n_nonzero))
+            take_snapshot(engine,grid,record);
+    };
+
+    // the tree search splits the machines into subtrees, searched as separate chunks
+    BasicTreeSearch<Grid> tree(possible_entries,N_COLORS,allowed,start_turmite,run_turmite,tree_record);
+    if(options.tree)
+    {
+        // the split must come out the same for every shard, and when resuming
+        const size_t n_subtrees = options.n_shards>1 ? 256*options.n_shards : 16*checkpoint.chunking;
+        const unsigned long long n_ruled_out = tree.split(n_subtrees,grids[0]);
+        if(!options.resume && options.shard==1)
+            tried += n_ruled_out; // else already counted, in the checkpoint or by the first shard
+    }
+
+    // the part of the search covered by this shard: a range of machines for the odometer, a range of
+    // subtrees for the tree search
+    unsigned long long slice_first,slice_last;
+    shard_slice(options.tree ? tree.n_chunks() : target,options.shard,options.n_shards,slice_first,slice_last);
+    if(slice_first==slice_last)
+    {
+        cout << "Shard " << options.shard << "/" << options.n_shards << " is empty. Use fewer shards." << endl;
+        exit(1);
+    }
+    ostringstream slice;
+    if(options.n_shards>1)
+        slice << " (shard " << options.shard << "/" << options.n_shards << ": " << (options.tree ? "subtrees " : "machines ")
+            << slice_first << " to " << slice_last-1 << ")";
+    if(!options.resume)
+        out.write("Total number of machines: "+to_string(target)+slice.str()+"\n");
+
+    // the budget of a stage, as written in found_*.txt
+    auto stage_text = [&](int of_stage) -> string
+    {
+        ostringstream text;
+        text << "Stage " << of_stage+1 << " of " << n_stages << ": ";
+        if(of_stage==0)
+            text << "every machine";
+        else
+            text << "the " << stage_machines.size() << " machines held out by stage " << of_stage;
+        text << ", for up to " << budgets[of_stage].ITS << " steps";
+        if(!TILED)
+            text << ", no further than " << budgets[of_stage].R << " " << Topology::radius_unit() << " from the start";
+        text << "\n";
+        return text.str();
+    };
+    if(staged && !options.resume)
+    {
+        out.write(stage_text(0));
+        cout << stage_text(0);
+    }
+
+    // work through the machines of one chunk, keeping the records local to the chunk
+    const ChunkLayout layout = make_chunk_layout(possible_entries,checkpoint.chunking);
+    auto search_chunk = [&](int iThread,unsigned long long chunk,ChunkResult &result)
+    {
+        // the first stage runs a range of the odometer, the later ones a range of stage_machines
+        const unsigned long long first = stage==0 ? max(chunk*layout.stride,max(slice_first,first_machine)) : chunk*settings.HELD_OUT_CHUNK;
+        const unsigned long long last = stage==0 ? min((chunk+1)*layout.stride,slice_last)
+            : min((chunk+1)*settings.HELD_OUT_CHUNK,(unsigned long long)stage_machines.size());
+        vector<unsigned char> digits(N_SLOTS*3);
+        unsigned char *turmite = &digits[0]; // turmite[i] is an index into possible_entries[i]
+        int iEntry,iSlot,n_halts,max_its=-1,max_nonzero=-1;
+        bool satisfied;
+        TurmiteState t;
+        TransitionTable transitions(possible_entries,N_COLORS);
+        ReachabilityFilter reachability(possible_entries,N_STATES,N_COLORS);
+        index_to_turmite(stage==0 ? first : stage_machines[first],possible_entries,turmite);
+        transitions.compile(turmite);
+
+        // count the number of halts in the first turmite
+        n_halts=0;
+        for(iEntry=1;iEntry<N_SLOTS*3;iEntry+=3)
+        {
+            if(possible_entries[iEntry][turmite[iEntry]]==0)
+                n_halts++;
+        }
+
+        // move turmite[] on to the next machine that passes the filter, returns false at the end of the chunk
+        unsigned long long i = stage==0 ? first : stage_machines[first]; // the machine in turmite[]
+        unsigned long long iHeld=first; // after the first stage: the position of i in stage_machines
+        bool at_first=true; // machine first hasn't been looked at yet
+        auto next_candidate = [&]() -> bool
+        {
+            if(stage>0)
+            {
+                // (these passed the filters, and were counted as tried, in the first stage)
+                if(at_first)
+                    at_first = false;
+                else if(++iHeld<last)
+                {
+                    i = stage_machines[iHeld];
+                    index_to_turmite(i,possible_entries,turmite);
+                    transitions.compile(turmite);
+                }
+                return iHeld<last;
+            }
+            for(;;)
+            {
+                if(at_first)
+                    at_first = false;
+                else if(++i<last)
+                {
+                    // increment the turmite (the carry never leaves the chunk)
+                    for(iEntry=0;iEntry<3*N_SLOTS;iEntry++)
+                    {
+                        if(turmite[iEntry] < possible_entries[iEntry].size()-1)
+                        {
+                            if(iEntry%3==1 && possible_entries[iEntry][turmite[iEntry]]==0)
+                                n_halts--;
+                            turmite[iEntry]++;
+                            break;
+                        }
+                        else
+                        {
+                            turmite[iEntry]=0;
+                            if(iEntry%3==1 && possible_entries[iEntry][turmite[iEntry]]==0) n_halts++;
+                        }
+                    }
+                    transitions.update_after_increment(iEntry,turmite); // recompile the changed entries
+                }
+                if(i>=last)
+                    return false;
+                result.tried++;
+                if(n_halts!=1)
+                {
+                    result.stats.n_halts_filtered++;
+                    continue; // keep working through the possibilities
+                }
+                // the halt triple should be {1,0,0}
+                satisfied = false;
+                for(iEntry=1;iEntry<N_SLOTS*3;iEntry+=3)
+                {
+                    if(possible_entries[iEntry][turmite[iEntry]]==0)
+                    {
+                        // this is the halt triple (we know there's only one)
+                        // is it {1,0,0}?
+                        if(possible_entries[iEntry-1][turmite[iEntry-1]]==1 &&
+                            possible_entries[iEntry+1][turmite[iEntry+1]]==0)
+                        {
+                            satisfied=true;
+                            break;
+                        }
+                    }
+                }
+                if(!satisfied)
+                {
+                    result.stats.halt_filtered++;
+                    continue;
+                }
+                // any rules about single transitions
+                for(iSlot=0;iSlot<N_SLOTS && satisfied;iSlot++)
+                {
+                    iEntry = iSlot*3;
+                    satisfied = slot_allowed[iSlot][turmite[iEntry] + possible_entries[iEntry].size()
+                        *(turmite[iEntry+1] + possible_entries[iEntry+1].size()*turmite[iEntry+2])];
+                }
+                if(!satisfied)
+                {
+                    result.stats.rule_filtered++;
+                    continue;
+                }
+                if(use_symmetry && !symmetry.first_of_family(turmite))
+                {
+                    result.stats.symmetry_filtered++;
+                    continue;
+                }
+                if(use_reachability && !reachability.can_halt(turmite))
+                {
+                    result.n_unreachable++;
+                    result.stats.reachability_filtered++;
+                    continue;
+                }
+                return true;
+            }
+        };
+
+        // For the log and the pictures: the grid a halting machine halted on. If grids[iThread]
+        // doesn't hold its run (a memo hit, a run with macro-steps or in a batch lane) it is run
+        // again there.
+        bool run_on_grid = false; // grids[iThread] holds the run of the machine being recorded
+        TransitionTable replay_transitions(possible_entries,N_COLORS);
+        auto halted_grid = [&](const unsigned char *turmite) -> const Grid&
+        {
+            if(!run_on_grid)
+            {
+                TurmiteState u;
+                replay_transitions.compile(turmite);
+                grids[iThread].clear();
+                stage_engine->start(u);
+                stage_engine->run(replay_transitions,grids[iThread],u);
+                run_on_grid = true;
+            }
+            return grids[iThread];
+        };
+
+        // the outcome of a tested machine, in the order of the odometer
+        auto record_outcome = [&](RunOutcome outcome,int its,int n_nonzero,const unsigned char *turmite,unsigned long long machine)
+        {
+            if(staged && (outcome==OFF_GRID || outcome==TIMED_OUT))
+            {
+                // undecided with this stage's budget: run again in the next stage, or after the last
+                // listed as undecided
+                HeldOut entry;
+                entry.machine = machine;
+                entry.outcome = outcome;
+                result.held_out.push_back(entry);
+                if(stage<n_stages-1)
+                    return; // (not tested yet)
+            }
+            if(outcome==HALTED && log_halted && its>=options.log_halted)
+            {
+                FoundRecord entry;
+                entry.its = its;
+                entry.n_nonzero = n_nonzero;
+                entry.turmite.assign(turmite,turmite+N_SLOTS*3);
+                entry.bounds.resize(2*N_DIM);
+                stage_engine->bounds(halted_grid(turmite),&entry.bounds[0],&entry.bounds[N_DIM]);
+                result.halted.push_back(entry);
+            }
+            if(outcome==HALTED)
+            {
+                // is it a new record for this chunk?
+                if(its>max_its || n_nonzero>max_nonzero)
+                {
+                    max_its = max(its,max_its);
+                    max_nonzero = max(n_nonzero,max_nonzero);
+                    FoundRecord record;
+                    record.its = its;
+                    record.n_nonzero = n_nonzero;
+                    record.turmite.assign(turmite,turmite+N_SLOTS*3);
+                    if(wants_snapshot(its,n_nonzero))
+                        take_snapshot(*stage_engine,halted_grid(turmite),record);
+                    result.records.push_back(record);
+                }
+            }
+            else
+                result.count_rejected(outcome,1);
+            if(options.save_outcomes)
+            {
+                StoredOutcome entry;
+                entry.machine = machine;
+                entry.outcome = outcome;
+                entry.its = its;
+                entry.n_nonzero = outcome==HALTED ? n_nonzero : 0;
+                result.outcomes.push_back(entry);
+            }
+            result.stats.count(outcome,its,1);
+            result.tested++;
+        };
+
+        // a machine that has the same transitions as an earlier one in every slot that it read runs
+        // the same way, so its outcome is taken from the memo
+        if(use_memo && !memos[iThread])
+            memos[iThread].reset(new OutcomeMemo(possible_entries,settings.MEMO_ENTRIES));
+        OutcomeMemo::Outcome known;
+
+        // with --reuse, a machine whose outcome is known with our limits from the earlier search
+        if(use_store && !store_cursors[iThread])
+            store_cursors[iThread].reset(new OutcomeStore::Cursor(store));
+        StoredOutcome stored,reused;
+        auto reuse_outcome = [&]() -> bool
+        {
+            if(!use_store || !store_cursors[iThread]->find(i,stored) || !store.carry_over(stored,ITS,R,reused))
+                return false;
+            result.stats.reused++;
+            return true;
+        };
+
+        if(!options.batch)
+        {
+            while(next_candidate())
+            {
+                if(reuse_outcome())
+                {
+                    run_on_grid = false;
+                    record_outcome(reused.outcome,reused.its,reused.n_nonzero,turmite,i);
+                    continue;
+                }
+                if(use_memo && memos[iThread]->find(turmite,known))
+                {
+                    run_on_grid = false;
+                    result.stats.memo_hits++;
+                    record_outcome(known.outcome,known.its,known.n_nonzero,turmite,i);
+                    continue;
+                }
+                // test the turmite
+                grids[iThread].clear(); // undo the writes of the previous turmite
+                first_engine->start(t);
+                RunOutcome outcome = first_engine->run(transitions,grids[iThread],t);
+                run_on_grid = outcome!=TIMED_OUT || !use_macro;
+                if(outcome==TIMED_OUT && use_macro)
+                    outcome = run_long(iThread,transitions,t);
+                if(use_memo)
+                    memos[iThread]->add(turmite,t.max_slot,outcome,t.its,t.n_nonzero);
+                record_outcome(outcome,t.its,t.n_nonzero,turmite,i);
+            }
+            return;
+        }
+
+        // Test the turmites Batch::LANES at a time. They finish out of order, so the ones that
+        // halted wait in pending until every earlier machine has finished. Those still running
+        // after the batch engine's limit are run again here, as without --batch.
+        if(!batches[iThread])
+            batches[iThread].reset(new Batch(budgets[stage].R,FIRST_ITS,N_STATES,N_COLORS));
+        const unsigned long long EMPTY = ~0ULL;
+        vector<unsigned long long> lane_machine(Batch::LANES,EMPTY); // the machine in each lane
+        vector<vector<unsigned char> > lane_turmite(Batch::LANES);
+        map<unsigned long long,FoundRecord> pending;
+        TransitionTable lane_transitions(possible_entries,N_COLORS);
+        auto machine_done = [&](unsigned long long machine,RunOutcome outcome,int its,int n_nonzero,const unsigned char *digits)
+        {
+            run_on_grid = false;
+            if(outcome!=HALTED)
+            {
+                record_outcome(outcome,its,n_nonzero,digits,machine); // (the order doesn't matter, held_out and outcomes are sorted below)
+                return;
+            }
+            FoundRecord &halted = pending[machine];
+            halted.its = its;
+            halted.n_nonzero = n_nonzero;
+            halted.turmite.assign(digits,digits+N_SLOTS*3);
+            const unsigned long long running = *min_element(lane_machine.begin(),lane_machine.end());
+            while(!pending.empty() && pending.begin()->first<running)
+            {
+                const FoundRecord &record = pending.begin()->second;
+                run_on_grid = false;
+                record_outcome(HALTED,record.its,record.n_nonzero,&record.turmite[0],pending.begin()->first);
+                pending.erase(pending.begin());
+            }
+        };
+        batches[iThread]->run([&](int iLane) -> const TransitionTable*
+            {
+                for(;;)
+                {
+                    if(!next_candidate())
+                        return NULL;
+                    if(reuse_outcome())
+                    {
+                        machine_done(i,reused.outcome,reused.its,reused.n_nonzero,turmite);
+                        continue;
+                    }
+                    if(use_memo && memos[iThread]->find(turmite,known))
+                    {
+                        result.stats.memo_hits++;
+                        machine_done(i,known.outcome,known.its,known.n_nonzero,turmite);
+                        continue;
+                    }
+                    lane_machine[iLane] = i;
+                    lane_turmite[iLane].assign(turmite,turmite+N_SLOTS*3);
+                    return &transitions;
+                }
+            },
+            [&](int iLane,RunOutcome outcome,int its,int n_nonzero,int max_slot)
+            {
+                const unsigned long long machine = lane_machine[iLane];
+                lane_machine[iLane] = EMPTY;
+                if(outcome==TIMED_OUT && (its<FIRST_ITS || use_macro))
+                {
+                    lane_transitions.compile(&lane_turmite[iLane][0]);
+                    if(its<FIRST_ITS)
+                    {
+                        grids[iThread].clear();
+                        first_engine->start(t);
+                        outcome = first_engine->run(lane_transitions,grids[iThread],t);
+                    }
+                    if(outcome==TIMED_OUT && use_macro)
+                        outcome = run_long(iThread,lane_transitions,t);
+                    its = t.its;
+                    n_nonzero = t.n_nonzero;
+                    max_slot = t.max_slot;
+                }
+                if(use_memo)
+                    memos[iThread]->add(&lane_turmite[iLane][0],max_slot,outcome,its,n_nonzero);
+                machine_done(machine,outcome,its,n_nonzero,&lane_turmite[iLane][0]);
+            });
+        for(auto it=pending.begin();it!=pending.end();it++)
+        {
+            run_on_grid = false;
+            record_outcome(HALTED,it->second.its,it->second.n_nonzero,&it->second.turmite[0],it->first);
+        }
+        sort(result.held_out.begin(),result.held_out.end(),
+            [](const HeldOut &a,const HeldOut &b) { return a.machine<b.machine; });
+        sort(result.outcomes.begin(),result.outcomes.end(),
+            [](const StoredOutcome &a,const StoredOutcome &b) { return a.machine<b.machine; });
+    };
+
+    // save the position of the search, when every chunk before next_chunk has been committed
+    time_t last_checkpoint = time(NULL);
+    auto write_checkpoint = [&](unsigned long long next_chunk)
+    {
+        out.flush();
+        log.flush();
+        held_out.flush();
+        outcomes_out.flush();
+        checkpoint.next_chunk = next_chunk;
+        checkpoint.tried = tried;
+        checkpoint.tested = tested;
+        checkpoint.n_unreachable = n_unreachable;
+        checkpoint.n_off_grid = n_off_grid;
+        checkpoint.n_cycled = n_cycled;
+        checkpoint.n_timed_out = n_timed_out;
+        checkpoint.max_its = max_its;
+        checkpoint.max_nonzero = max_nonzero;
+        checkpoint.found_size = out.size();
+        checkpoint.log_size = log.size();
+        checkpoint.stage = stage;
+        checkpoint.held_out_size = held_out.size();
+        checkpoint.outcomes_size = outcomes_out.size();
+        if(!save_checkpoint(checkpoint_filename,checkpoint))
+            cout << "Failed to save checkpoint: " << checkpoint_filename << endl;
+        last_checkpoint = time(NULL);
+    };
+
+    // the machine as written in found_*.txt: {{{color,move,state},...},...} with a triple for each
+    // state and color
+    auto table_text = [&](const unsigned char *turmite) -> string
+    {
+        ostringstream text;
+        text << "{";
+        for(int iState=0;iState<N_STATES;iState++)
+        {
+            if(iState>0)
+                text << ",";
+            text << "{";
+            for(int iColor=0;iColor<N_COLORS;iColor++)
+            {
+                const int iEntry = (iState*N_COLORS+iColor)*3;
+                if(iColor>0)
+                    text << ",";
+                text << "{";
+                text << (int)possible_entries[iEntry+0][turmite[iEntry+0]] << ",";
+                text << Topology::move_text(possible_entries[iEntry+1][turmite[iEntry+1]],Movement::RELATIVE) << ",";
+                text << (int)possible_entries[iEntry+2][turmite[iEntry+2]];
+                text << "}";
+            }
+            text << "}";
+        }
+        text << "}";
+        return text.str();
+    };
+
+    // a line of the log of halting machines: the steps, the population, the bounding box of its cells
+    // relative to the start ([lowest,highest] along each axis), the transitions as [color,move,state]
+    // for each state and color (the move numbered as in grid_topology.h, 0 for halt) and the table as
+    // in found_*.txt
+    auto log_line = [&](const FoundRecord &entry) -> string
+    {
+        ostringstream line;
+        line << "{\"steps\":" << entry.its << ",\"population\":" << entry.n_nonzero << ",\"bounds\":[";
+        for(int iDim=0;iDim<N_DIM;iDim++)
+            line << (iDim>0 ? "," : "") << "[" << entry.bounds[iDim] << "," << entry.bounds[N_DIM+iDim] << "]";
+        line << "],\"transitions\":[";
+        for(int iSlot=0;iSlot<N_SLOTS;iSlot++)
+        {
+            const int iEntry = iSlot*3;
+            line << (iSlot>0 ? "," : "") << "[" << (int)possible_entries[iEntry+0][entry.turmite[iEntry+0]]
+                << "," << (int)possible_entries[iEntry+1][entry.turmite[iEntry+1]]
+                << "," << (int)possible_entries[iEntry+2][entry.turmite[iEntry+2]] << "]";
+        }
+        line << "],\"table\":\"" << table_text(&entry.turmite[0]) << "\"}\n";
+        return line.str();
+    };
+
+    // with --stats, save the counts of search_stats.h now and then
+    SearchStats stats;
+    const chrono::steady_clock::time_point started = chrono::steady_clock::now();
+    time_t last_stats = time(NULL);
+    auto write_stats = [&](bool finished)
+    {
+        ostringstream line;
+        line << "{\"seconds\":" << chrono::duration<double>(chrono::steady_clock::now()-started).count()
+            << ",\"finished\":" << (finished ? "true" : "false") << ",\"tried\":" << tried << ",\"tested\":" << tested << ",";
+        stats.write_fields(line);
+        line << "}\n";
+        stats_out.write(line.str());
+        last_stats = time(NULL);
+    };
+
+    RenderQueue render(settings.draw_record); // (waits for the pictures still queued when the search ends)
+
+    // merge the chunk records into the overall records, in the same order as a single-threaded run
+    auto commit_chunk = [&](unsigned long long chunk,ChunkResult &result)
+    {
+        ostringstream text;
+        for(size_t iRecord=0;iRecord<result.records.size();iRecord++)
+        {
+            const int its = result.records[iRecord].its;
+            const int n_nonzero = result.records[iRecord].n_nonzero;
+            const unsigned char *turmite = &result.records[iRecord].turmite[0];
+            // is it a new record?
+            if(its>max_its || n_nonzero>max_nonzero)
+            {
+                if(its>max_its)
+                {
+                    max_its = its;
+                    text << "New steps record:\n";
+                }
+                if(n_nonzero>max_nonzero)
+                {
+                    max_nonzero = n_nonzero;
+                    text << "New high score:\n";
+                }
+                text << its << " (popn. " << n_nonzero << "): " << table_text(turmite) << "\n";
+                if(settings.draw_record)
+                {
+                    // the worker that found it copied its cells (see take_snapshot)
+                    FoundRecord &record = result.records[iRecord];
+                    GridSnapshot snapshot;
+                    snapshot.its = its;
+                    snapshot.n_nonzero = n_nonzero;
+                    snapshot.lo.assign(record.bounds.begin(),record.bounds.begin()+N_DIM);
+                    snapshot.hi.assign(record.bounds.begin()+N_DIM,record.bounds.end());
+                    snapshot.colors.swap(record.cells);
+                    render.add(snapshot);
+                }
+            }
+        }
+        committed_its = max_its;
+        committed_nonzero = max_nonzero;
+        out.write(text.str());
+        if(log_halted)
+        {
+            string lines;
+            for(size_t iEntry=0;iEntry<result.halted.size();iEntry++)
+                lines += log_line(result.halted[iEntry]);
+            log.write(lines);
+        }
+        if(staged)
+        {
+            string lines;
+            vector<unsigned char> turmite(N_SLOTS*3);
+            for(size_t iEntry=0;iEntry<result.held_out.size();iEntry++)
+            {
+                const HeldOut &entry = result.held_out[iEntry];
+                index_to_turmite(entry.machine,possible_entries,&turmite[0]);
+                lines += to_string(entry.machine) + (entry.outcome==OFF_GRID ? " off_grid " : " timed_out ") + table_text(&turmite[0]) + "\n";
+            }
+            held_out.write(lines);
+        }
+        if(options.save_outcomes)
+        {
+            string bytes;
+            OutcomeStore::encode(result.outcomes,bytes);
+            outcomes_out.write(bytes);
+        }
+        const unsigned long long tested_before = tested;
+        tried += result.tried;
+        tested += result.tested;
+        n_unreachable += result.n_unreachable;
+        n_off_grid += result.n_off_grid;
+        n_cycled += result.n_cycled;
+        n_timed_out += result.n_timed_out;
+        stats.add(result.stats);
+        if(options.stats && difftime(time(NULL),last_stats)>=settings.STATS_EVERY)
+            write_stats(false);
+        if(tested/settings.PRINT_EVERY > tested_before/settings.PRINT_EVERY)
+        {
+            cout << "Tried: " << tried << " (" << 100*(tried/(float)target) << "%) Tested: " << tested;
+            if(use_reachability) // (and the share of the machines that passed the other filters)
+                cout << " Can't halt: " << n_unreachable << " (" << 100*(n_unreachable/(float)(n_unreachable+tested)) << "%)";
+            cout << " Best steps: " << max_its << " Best score: " << max_nonzero << endl;
+        }
+        if(difftime(time(NULL),last_checkpoint)>=settings.CHECKPOINT_EVERY)
+            write_checkpoint(chunk+1);
+    };
+
+    cout << "Searching with " << n_threads << " thread(s)." << endl;
+    install_stop_handlers(); // on SIGINT or SIGTERM, save a checkpoint before exiting
+    unsigned long long next_chunk;
+    if(options.tree)
+        next_chunk = ChunkPool::run(n_threads,options.resume ? checkpoint.next_chunk : slice_first,slice_last,
+            [&](int iThread,unsigned long long chunk,ChunkResult &result) { tree.search_chunk(chunk,grids[iThread],result); },
+            commit_chunk,stop_requested);
+    else
+    {
+        unsigned long long first_chunk = options.resume ? checkpoint.next_chunk : max(slice_first,first_machine)/layout.stride;
+        for(;;)
+        {
+            const unsigned long long n_chunks = stage==0 ? (slice_last+layout.stride-1)/layout.stride
+                : (stage_machines.size()+settings.HELD_OUT_CHUNK-1)/settings.HELD_OUT_CHUNK;
+            next_chunk = ChunkPool::run(n_threads,first_chunk,n_chunks,search_chunk,commit_chunk,stop_requested);
+            if(stop_requested() || stage==n_stages-1)
+                break;
+            // the machines held out by this stage are the next stage's
+            held_out.close();
+            if(!read_held_out(stage))
+            {
+                cout << "Failed to read the machines held out by stage " << stage+1 << ": " << held_out_filename(stage) << endl;
+                exit(1);
+            }
+            if(!held_out.open(held_out_filename(stage+1),false))
+            {
+                cout << "Failed to open the results files: " << held_out_filename(stage+1) << endl;
+                exit(1);
+            }
+            begin_stage(stage+1);
+            out.write(stage_text(stage));
+            cout << stage_text(stage);
+            first_chunk = 0;
+        }
+    }
+
+    if(options.stats)
+        write_stats(!stop_requested());
+    if(stop_requested())
+    {
+        write_checkpoint(next_chunk);
+        cout << "Stopped. Run again with --resume to continue the search." << endl;
+        return 0;
+    }
+    remove(checkpoint_filename.c_str()); // the search is complete
+
+    cout << "Rejected: " << n_off_grid << " moved off the grid, " << n_cycled << " repeated a configuration, " << n_timed_out << " still running after " << ITS << " steps";
+    if(use_reachability)
+        cout << ", and " << n_unreachable << " weren't run because they can't reach their halt";
+    cout << "." << endl;
+    ostringstream text;
+    if(options.n_shards>1)
+        text << "Shard totals: tried " << tried << ", tested " << tested << ", moved off the grid " << n_off_grid << ", repeated a configuration " << n_cycled << ", still running " << n_timed_out << "\n";
+    if(staged)
+    {
+        // every other machine was decided, so these are exactly the ones that could still be better
+        text << "Run completed" << slice.str() << ". " << n_off_grid+n_timed_out << " machines are undecided after the last stage ("
+            << n_timed_out << " still running after " << ITS << " steps, " << n_off_grid;
+        if(TILED && options.memory_mb>0)
+            text << " needing more than " << options.memory_mb << "MB of grid";
+        else
+            text << " moving more than " << R << " " << Topology::radius_unit() << " from the starting position";
+        text << "), listed in " << held_out_filename(n_stages-1) << ".\n";
+        cout << "Undecided machines are listed in: " << held_out_filename(n_stages-1) << endl;
+    }
+    else
+    {
+        text << "Run completed" << slice.str() << ". If better machines exist then they take more than " << ITS << " steps";
+        if(TILED && options.memory_mb>0)
+            text << " or need more than " << options.memory_mb << "MB of grid";
+        else if(!TILED)
+            text << " or move more than " << R << " " << Topology::radius_unit() << " from the starting position";
+        text << ".\n";
+    }
+    out.write(text.str());
+    return 0;
+}
+
+// Runs search_turmites with the kernel compiled for the number of states and colors if there is one
+// (2 to 4 states, 2 or 3 colors), else with the generic kernel that is told them at run time. To
+// keep the build time down, unbounded searches only have their own kernels on grids of up to 2D.
+template<class Topology,class Movement,bool TILED>
+typename std::enable_if<MovementSupported<Topology,Movement>::value && (!TILED || Topology::N_DIM<=2),int>::type
+dispatch_search(const SearchSettings &settings,const SearchOptions &options,
+    const std::vector<std::vector<unsigned char> > &possible_entries,TreeSearch::TransitionFilter allowed)
+{
+    if(options.n_colors==2)
+    {
+        if(options.n_states==2) return search_turmites<Topology,Movement,2,2,TILED>(settings,options,possible_entries,allowed);
+        if(options.n_states==3) return search_turmites<Topology,Movement,3,2,TILED>(settings,options,possible_entries,allowed);
+        if(options.n_states==4) return search_turmites<Topology,Movement,4,2,TILED>(settings,options,possible_entries,allowed);
+    }
+    else if(options.n_colors==3)
+    {
+        if(options.n_states==2) return search_turmites<Topology,Movement,2,3,TILED>(settings,options,possible_entries,allowed);
+        if(options.n_states==3) return search_turmites<Topology,Movement,3,3,TILED>(settings,options,possible_entries,allowed);
+        if(options.n_states==4) return search_turmites<Topology,Movement,4,3,TILED>(settings,options,possible_entries,allowed);
+    }
+    return search_turmites<Topology,Movement,RUNTIME,RUNTIME,TILED>(settings,options,possible_entries,allowed);
+}
+
+template<class Topology,class Movement,bool TILED>
+typename std::enable_if<MovementSupported<Topology,Movement>::value && TILED && (Topology::N_DIM>2),int>::type
+dispatch_search(const SearchSettings &settings,const SearchOptions &options,
+    const std::vector<std::vector<unsigned char> > &possible_entries,TreeSearch::TransitionFilter allowed)
+{
+    return search_turmites<Topology,Movement,RUNTIME,RUNTIME,TILED>(settings,options,possible_entries,allowed);
+}
+
+template<class Topology,class Movement,bool TILED>
+typename std::enable_if<!MovementSupported<Topology,Movement>::value,int>::type
+dispatch_search(const SearchSettings&,const SearchOptions&,
+    const std::vector<std::vector<unsigned char> >&,TreeSearch::TransitionFilter)
+{
+    std::cout << (Movement::RELATIVE ? "Relative" : "Absolute") << " turmites are not supported on this grid." << std::endl;
+    return 1;
+}
+
+// Runs the search on the given grid, for the movement chosen on the command line.
+template<class Topology>
+int search_grid(const SearchSettings &settings,const SearchOptions &options,
+    const std::vector<std::vector<unsigned char> > &possible_entries,TreeSearch::TransitionFilter allowed)
+{
+    if(options.unbounded)
+    {
+        if(options.relative)
+            return dispatch_search<Topology,RelativeMovement,true>(settings,options,possible_entries,allowed);
+        return dispatch_search<Topology,AbsoluteMovement,true>(settings,options,possible_entries,allowed);
+    }
+    if(options.relative)
+        return dispatch_search<Topology,RelativeMovement,false>(settings,options,possible_entries,allowed);
+    return dispatch_search<Topology,AbsoluteMovement,false>(settings,options,possible_entries,allowed);
+}
+
+#endif
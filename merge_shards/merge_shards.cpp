@@ -0,0 +1,165 @@
+// Combines the found_*.txt files written by the shards of a search (--shard k/N) into the file
+// that a single run of the whole search would have written.
+//
+// Each shard logs the records it found relative to its own best so far. Replaying the shards'
+// records in shard order, and keeping only those that beat the overall best so far, gives the
+// same records as the single run, in the same order.
+
+// stdlib:
+#include <stdio.h>
+#include <stdlib.h>
+
+// STL:
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct ShardRecord
+{
+    int its;
+    int n_nonzero;
+    string line; // e.g. "171 (popn. 27): {{{1,2,1},{1,0,0}},{{0,4,1},{1,32,0}}}"
+};
+
+struct ShardFile
+{
+    int shard,n_shards;
+    unsigned long long n_machines;
+    vector<ShardRecord> records; // in the order they were found
+    bool has_totals;
+    unsigned long long tried,tested,n_off_grid,n_cycled,n_timed_out;
+    string completed; // the "Run completed" line without the shard, empty if the shard didn't finish
+};
+
+// returns the text of the line without the " (shard k/N: ...)" that follows the given prefix
+string remove_shard_text(const string& line,const string& prefix)
+{
+    const size_t start = prefix.size();
+    if(line.compare(start,8," (shard ")!=0)
+        return line;
+    const size_t end = line.find(')',start);
+    if(end==string::npos)
+        return line;
+    return line.substr(0,start)+line.substr(end+1);
+}
+
+bool read_shard_file(const string& filename,ShardFile& f)
+{
+    ifstream in(filename.c_str());
+    string line;
+    if(!getline(in,line) || sscanf(line.c_str(),"Total number of machines: %llu (shard %d/%d",
+        &f.n_machines,&f.shard,&f.n_shards)!=3)
+    {
+        cout << filename << " is not the results file of a shard." << endl;
+        return false;
+    }
+    f.has_totals = false;
+    while(getline(in,line))
+    {
+        if(!line.empty() && line[line.size()-1]=='\r')
+            line.erase(line.size()-1);
+        ShardRecord record;
+        if(sscanf(line.c_str(),"%d (popn. %d):",&record.its,&record.n_nonzero)==2)
+        {
+            record.line = line;
+            f.records.push_back(record);
+        }
+        else if(sscanf(line.c_str(),"Shard totals: tried %llu, tested %llu, moved off the grid %llu, repeated a configuration %llu, still running %llu",
+            &f.tried,&f.tested,&f.n_off_grid,&f.n_cycled,&f.n_timed_out)==5)
+            f.has_totals = true;
+        else if(line.compare(0,13,"Run completed")==0)
+            f.completed = remove_shard_text(line,"Run completed");
+        // else "New steps record:" or "New high score:", which we work out again
+    }
+    return true;
+}
+
+int main(int argc,char *argv[])
+{
+    if(argc<3)
+    {
+        cout << "Usage: " << argv[0] << " <output file> <shard results file> [<shard results file> ...]\n"
+            << "Merges the found_*.txt files of every shard of a search (in any order).\n";
+        exit(1);
+    }
+
+    vector<ShardFile> shards;
+    for(int iArg=2;iArg<argc;iArg++)
+    {
+        ShardFile f;
+        if(!read_shard_file(argv[iArg],f))
+            exit(1);
+        if(!shards.empty() && (f.n_shards!=shards[0].n_shards || f.n_machines!=shards[0].n_machines))
+        {
+            cout << argv[iArg] << " is from a different search to " << argv[2] << endl;
+            exit(1);
+        }
+        if(f.completed.empty() || !f.has_totals)
+        {
+            cout << argv[iArg] << " is from a shard that didn't finish. Resume it with --resume." << endl;
+            exit(1);
+        }
+        shards.push_back(f);
+    }
+
+    // put the shards in order, checking that each appears exactly once
+    const int n_shards = shards[0].n_shards;
+    vector<int> order(n_shards,-1);
+    for(size_t iShard=0;iShard<shards.size();iShard++)
+    {
+        const int k = shards[iShard].shard;
+        if(order[k-1]!=-1)
+        {
+            cout << "Shard " << k << "/" << n_shards << " was given more than once." << endl;
+            exit(1);
+        }
+        order[k-1] = (int)iShard;
+    }
+    for(int k=1;k<=n_shards;k++)
+    {
+        if(order[k-1]==-1)
+        {
+            cout << "Shard " << k << "/" << n_shards << " is missing." << endl;
+            exit(1);
+        }
+    }
+
+    ofstream out(argv[1]);
+    out << "Total number of machines: " << shards[0].n_machines << endl;
+    int max_its=-1,max_nonzero=-1;
+    unsigned long long tried=0,tested=0,n_off_grid=0,n_cycled=0,n_timed_out=0;
+    for(int k=1;k<=n_shards;k++)
+    {
+        const ShardFile& f = shards[order[k-1]];
+        for(size_t iRecord=0;iRecord<f.records.size();iRecord++)
+        {
+            const ShardRecord& record = f.records[iRecord];
+            if(record.its>max_its || record.n_nonzero>max_nonzero)
+            {
+                if(record.its>max_its)
+                {
+                    max_its = record.its;
+                    out << "New steps record:\n";
+                }
+                if(record.n_nonzero>max_nonzero)
+                {
+                    max_nonzero = record.n_nonzero;
+                    out << "New high score:\n";
+                }
+                out << record.line << endl;
+            }
+        }
+        tried += f.tried;
+        tested += f.tested;
+        n_off_grid += f.n_off_grid;
+        n_cycled += f.n_cycled;
+        n_timed_out += f.n_timed_out;
+    }
+    out << shards[0].completed << endl;
+
+    cout << "Merged " << n_shards << " shards into: " << argv[1] << endl;
+    cout << "Tried: " << tried << " Tested: " << tested << " Best steps: " << max_its << " Best score: " << max_nonzero << endl;
+    cout << "Rejected: " << n_off_grid << " moved off the grid, " << n_cycled << " repeated a configuration, " << n_timed_out << " still running." << endl;
+}